@@ -212,6 +212,7 @@ class Config:
 
         if ( useGtk ):
             env.ParseConfig( 'pkg-config gtk+-2.0 --cflags --libs' )
+            env.ParseConfig( 'pkg-config gthread-2.0 --cflags --libs' )
             env.ParseConfig( 'pkg-config x11 --cflags --libs' )
         else:
             # always setup at least glib
@@ -433,7 +433,7 @@ typedef struct {
 	bool rowDirty[( ( MAX_PATCH_WIDTH - 1 ) - 1 ) / 2];
 	bool colDirty[( ( MAX_PATCH_HEIGHT - 1 ) - 1 ) / 2];
 	bool LODUpdated;
-	void *drawLists; // pointer to std::list
+	void *drawLists; // cached flat tessellation (patchTess_t in pmesh.cpp)
 } patchMesh_t;
 
 typedef struct brush_s
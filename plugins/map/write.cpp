@@ -26,19 +26,135 @@
 static int g_count_entities;
 static int g_count_brushes;
 
+#include <math.h>
+#include <string.h>
 #include "plugin.h"
 extern int g_MapVersion;
 
-void Float_Write( float data, IDataStream *out ){
+// buffered output, the map is written in large chunks instead of one IDataStream::printf per token
+#define MAPWRITER_BUFSIZE 65536
+
+class CMapWriter
+{
+public:
+CMapWriter( IDataStream *out ) : m_out( out ), m_len( 0 ) {
+}
+~CMapWriter() {
+	Flush();
+}
+void Flush(){
+	if ( m_len ) {
+		m_out->Write( m_buf, m_len );
+		m_len = 0;
+	}
+}
+// make room for at least n bytes
+char *Reserve( unsigned long n ){
+	if ( m_len + n > MAPWRITER_BUFSIZE ) {
+		Flush();
+	}
+	return m_buf + m_len;
+}
+void Commit( unsigned long n ){
+	m_len += n;
+}
+void Str( const char *str ){
+	unsigned long n = strlen( str );
+	if ( n > MAPWRITER_BUFSIZE / 2 ) {
+		// long key values, no point in copying them around
+		Flush();
+		m_out->Write( str, n );
+		return;
+	}
+	memcpy( Reserve( n ), str, n );
+	Commit( n );
+}
+void Int( int data ){
+	char tmp[16], *p = tmp + sizeof( tmp );
+	unsigned int u = ( data < 0 ) ? 0u - (unsigned int)data : (unsigned int)data;
+	do
+	{
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while ( u );
+	if ( data < 0 ) {
+		*--p = '-';
+	}
+	unsigned long n = tmp + sizeof( tmp ) - p;
+	memcpy( Reserve( n ), p, n );
+	Commit( n );
+}
+void Float( float data );
+private:
+IDataStream *m_out;
+unsigned long m_len;
+char m_buf[MAPWRITER_BUFSIZE];
+};
+
+// writes the shortest fixed point decimal that parses back (through atof, as parse.cpp does) to the exact same float
+// falls back to %.9g, which always round-trips, for values that would need more than 9 decimals
+void CMapWriter::Float( float data ){
+	static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+	double d = fabs( (double)data );
+	int k;
+
+	for ( k = 1; k <= 9; k++ )
+	{
+		double scaled = floor( d * pow10[k] + 0.5 );
+		if ( scaled >= 9007199254740992.0 ) { // 2^53, integers above this are not exact
+			break;
+		}
+		// both operands are exact, so the quotient is the same double atof produces from the decimal
+		if ( (float)( scaled / pow10[k] ) != (float)d ) {
+			continue;
+		}
+
+		// emit the integer part, the point and k decimals
+		char tmp[32], *p = tmp + sizeof( tmp );
+		unsigned long long u = (unsigned long long)scaled;
+		for ( int i = 0; i < k; i++ )
+		{
+			*--p = '0' + (int)( u % 10 );
+			u /= 10;
+		}
+		*--p = '.';
+		do
+		{
+			*--p = '0' + (int)( u % 10 );
+			u /= 10;
+		} while ( u );
+		if ( data < 0 ) {
+			*--p = '-';
+		}
+		unsigned long n = tmp + sizeof( tmp ) - p;
+		memcpy( Reserve( n ), p, n );
+		Commit( n );
+		return;
+	}
+
+	Commit( sprintf( Reserve( 32 ), "%.9g", data ) );
+}
+
+void Float_Write( float data, CMapWriter &out ){
 	if ( data == (int)data ) {
-		out->printf( "%i ", (int)data );
+		out.Int( (int)data );
 	}
 	else{
-		out->printf( "%f ", data );
+		out.Float( data );
 	}
+	out.Str( " " );
 }
 
-void Patch_Write( patchMesh_t *pPatch, IDataStream *out ){
+void SurfaceFlags_Write( face_t *face, CMapWriter &out ){
+	out.Int( face->texdef.contents );
+	out.Str( " " );
+	out.Int( face->texdef.flags );
+	out.Str( " " );
+	out.Int( face->texdef.value );
+	out.Str( "\n" );
+}
+
+void Patch_Write( patchMesh_t *pPatch, CMapWriter &out ){
 	int i, j;
 	const char *str;
 
@@ -51,17 +167,22 @@ void Patch_Write( patchMesh_t *pPatch, IDataStream *out ){
 	if ( !strncmp( str, "textures/", 9 ) ) {
 		str += 9;
 	}
-	out->printf( "patchDef2\n{\n%s\n( %i %i 0 0 0 )\n",
-				 str, pPatch->width, pPatch->height );
+	out.Str( "patchDef2\n{\n" );
+	out.Str( str );
+	out.Str( "\n( " );
+	out.Int( pPatch->width );
+	out.Str( " " );
+	out.Int( pPatch->height );
+	out.Str( " 0 0 0 )\n" );
 
 	// write matrix
-	out->printf( "(\n" );
+	out.Str( "(\n" );
 	for ( i = 0; i < pPatch->width; i++ )
 	{
-		out->printf( "( " );
+		out.Str( "( " );
 		for ( j = 0; j < pPatch->height; j++ )
 		{
-			out->printf( "( " );
+			out.Str( "( " );
 
 			Float_Write( pPatch->ctrl[i][j].xyz[0], out );
 			Float_Write( pPatch->ctrl[i][j].xyz[1], out );
@@ -69,37 +190,37 @@ void Patch_Write( patchMesh_t *pPatch, IDataStream *out ){
 			Float_Write( pPatch->ctrl[i][j].st[0], out );
 			Float_Write( pPatch->ctrl[i][j].st[1], out );
 
-			out->printf( ") " );
+			out.Str( ") " );
 		}
-		out->printf( ")\n" );
+		out.Str( ")\n" );
 	}
-	out->printf( ")\n}\n" );
+	out.Str( ")\n}\n" );
 }
 
-void Face_Write( face_t *face, IDataStream *out, bool bAlternateTexdef = false ){
+void Face_Write( face_t *face, CMapWriter &out, bool bAlternateTexdef = false ){
 	int i, j;
 	const char *str;
 
 	// write planepts
 	for ( i = 0; i < 3; i++ )
 	{
-		out->printf( "( " );
+		out.Str( "( " );
 		for ( j = 0; j < 3; j++ )
 		{
 			Float_Write( face->planepts[i][j], out );
 		}
-		out->printf( ") " );
+		out.Str( ") " );
 	}
 
 	if ( bAlternateTexdef ) {
 		// write alternate texdef
-		out->printf( "( ( " );
+		out.Str( "( ( " );
 		for ( i = 0; i < 3; i++ )
 			Float_Write( face->brushprimit_texdef.coords[0][i], out );
-		out->printf( ") ( " );
+		out.Str( ") ( " );
 		for ( i = 0; i < 3; i++ )
 			Float_Write( face->brushprimit_texdef.coords[1][i], out );
-		out->printf( ") ) " );
+		out.Str( ") ) " );
 	}
 
 	// write shader name
@@ -120,84 +241,95 @@ void Face_Write( face_t *face, IDataStream *out, bool bAlternateTexdef = false )
 			str = pos + 1; // to speed optimize, change the "while" to an "if"
 		}
 	}
-	out->printf( "%s ", str );
+	out.Str( str );
+	out.Str( " " );
 
 	if ( !bAlternateTexdef ) {
 		// write texdef
-		out->printf( "%i %i %i %f %f ",
-					 (int)face->texdef.shift[0],
-					 (int)face->texdef.shift[1],
-					 (int)face->texdef.rotate,
-					 face->texdef.scale[0],
-					 face->texdef.scale[1] );
+		out.Int( (int)face->texdef.shift[0] );
+		out.Str( " " );
+		out.Int( (int)face->texdef.shift[1] );
+		out.Str( " " );
+		out.Int( (int)face->texdef.rotate );
+		out.Str( " " );
+		out.Float( face->texdef.scale[0] );
+		out.Str( " " );
+		out.Float( face->texdef.scale[1] );
+		out.Str( " " );
 	}
 
 	if ( g_MapVersion == MAPVERSION_Q3 ) {
 		// write surface flags
-		out->printf( "%i %i %i\n",
-					 face->texdef.contents,
-					 face->texdef.flags,
-					 face->texdef.value );
+		SurfaceFlags_Write( face, out );
 	}
 
 	if ( ( g_MapVersion == MAPVERSION_HL ) || ( g_MapVersion == MAPVERSION_Q2 ) ) {
 		// write surface flags if non-zero values.
 		if ( face->texdef.contents || face->texdef.flags || face->texdef.value ) {
-			out->printf( "%i %i %i\n",
-						 face->texdef.contents,
-						 face->texdef.flags,
-						 face->texdef.value );
+			SurfaceFlags_Write( face, out );
 		}
 		else
 		{
-			out->printf( "\n" );
+			out.Str( "\n" );
 		}
 	}
 
 }
 
-void Primitive_Write( brush_t *pBrush, IDataStream *out ){
+void Primitive_Write( brush_t *pBrush, CMapWriter &out ){
 	if ( ( g_MapVersion == MAPVERSION_Q2 ) && ( pBrush->patchBrush ) ) {
 		Sys_FPrintf( SYS_WRN, "WARNING: Primitive_Write: Patches are not supported in Quake2, ignoring Brush %d\n", g_count_brushes++ );
 	}
 	else
 	{
-		out->printf( "// brush %i\n", g_count_brushes++ );
-		out->printf( "{\n" );
+		out.Str( "// brush " );
+		out.Int( g_count_brushes++ );
+		out.Str( "\n" );
+		out.Str( "{\n" );
 		if ( pBrush->patchBrush ) {
 			Patch_Write( pBrush->pPatch, out );
 		}
 		else if ( pBrush->bBrushDef ) {
-			out->printf( "brushDef\n{\n" );
+			out.Str( "brushDef\n{\n" );
 			for ( face_t *face = pBrush->brush_faces; face != NULL; face = face->next )
 				Face_Write( face, out, true );
-			out->printf( "}\n" );
+			out.Str( "}\n" );
 		}
 		else{
 			for ( face_t *face = pBrush->brush_faces; face != NULL; face = face->next )
 				Face_Write( face, out );
 		}
-		out->printf( "}\n" );
+		out.Str( "}\n" );
 	}
 }
 
-void Entity_Write( entity_t *pEntity, IDataStream *out ){
+void Entity_Write( entity_t *pEntity, CMapWriter &out ){
 	epair_t *pEpair;
 	CPtrArray *brushes = (CPtrArray*)pEntity->pData;
-	out->printf( "// entity %i\n", g_count_entities++ );
-	out->printf( "{\n" );
+	out.Str( "// entity " );
+	out.Int( g_count_entities++ );
+	out.Str( "\n" );
+	out.Str( "{\n" );
 	for ( pEpair = pEntity->epairs; pEpair != NULL; pEpair = pEpair->next )
-		out->printf( "\"%s\" \"%s\"\n", pEpair->key, pEpair->value );
+	{
+		out.Str( "\"" );
+		out.Str( pEpair->key );
+		out.Str( "\" \"" );
+		out.Str( pEpair->value );
+		out.Str( "\"\n" );
+	}
 	g_count_brushes = 0;
 	for ( int i = 0; i < brushes->GetSize(); i++ )
 		Primitive_Write( (brush_t*)brushes->GetAt( i ), out );
-	out->printf( "}\n" );
+	out.Str( "}\n" );
 }
 
 void Map_Write( CPtrArray *map, IDataStream *out ){
+	CMapWriter *writer = new CMapWriter( out );
 	g_count_entities = 0;
 	for ( int i = 0; i < map->GetSize(); i++ )
-		Entity_Write( (entity_t*)map->GetAt( i ), out );
+		Entity_Write( (entity_t*)map->GetAt( i ), *writer );
+	delete writer; // flushes
 }
 
 void Map_WriteQ3( CPtrArray *map, IDataStream *out ){
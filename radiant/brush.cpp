@@ -44,16 +44,23 @@ const char* Brush_Name( brush_t *b ){
 }
 #endif
 
+// brushes and faces are allocated by the thousand on every load, undo, clone
+// and CSG op; slices keep them packed together and recycle them per thread
 brush_t *Brush_Alloc(){
-	brush_t *b = (brush_t*)qmalloc( sizeof( brush_t ) );
+	brush_t *b = g_slice_new0( brush_t );
 	return b;
 }
+
 /*
-   void Brush_Free(brush_t *b)
-   {
-   free(b);
-   }
+   ================
+   Brush_Dealloc
+
+   releases the brush_t itself, Brush_Free does the unlinking and cleanup
+   ================
  */
+void Brush_Dealloc( brush_t *b ){
+	g_slice_free( brush_t, b );
+}
 void PrintWinding( winding_t *w ){
 	int i;
 
@@ -168,7 +175,7 @@ float shift[2];
    ================
  */
 face_t *Face_Alloc( void ){
-	face_t *f = (face_t*)qmalloc( sizeof( *f ) );
+	face_t *f = g_slice_new0( face_t );
 	return f;
 }
 
@@ -181,12 +188,12 @@ void Face_Free( face_t *f ){
 	assert( f != 0 );
 
 	if ( f->face_winding ) {
-		free( f->face_winding );
+		Winding_Free( f->face_winding );
 		f->face_winding = 0;
 	}
 	f->texdef.~texdef_t();;
 
-	free( f );
+	g_slice_free( face_t, f );
 }
 
 /*
@@ -769,6 +776,10 @@ void DrawBrushEntityName( brush_t *b ){
 	}
 }
 
+// set while Brush_BuildWindings runs on worker threads, see Brush_SetBuildWindingsThreaded
+static bool g_bBrushBuildThreaded = false;
+static gint g_nBrushBuildUnusedPlanes = 0;
+
 /*
    =================
    Brush_MakeFaceWinding
@@ -796,7 +807,7 @@ winding_t *Brush_MakeFaceWinding( brush_t *b, face_t *face ){
 		if ( DotProduct( face->plane.normal, clip->plane.normal ) > 0.999
 			 && fabs( face->plane.dist - clip->plane.dist ) < 0.01 ) { // identical plane, use the later one
 			if ( past ) {
-				free( w );
+				Winding_Free( w );
 				return NULL;
 			}
 			continue;
@@ -813,12 +824,18 @@ winding_t *Brush_MakeFaceWinding( brush_t *b, face_t *face ){
 	}
 
 	if ( w->numpoints < 3 ) {
-		free( w );
+		Winding_Free( w );
 		w = NULL;
 	}
 
 	if ( !w ) {
-		Sys_FPrintf( SYS_WRN, "unused plane\n" );
+		// the console is not thread safe, Brush_BuildList reports these once the workers are done
+		if ( g_bBrushBuildThreaded ) {
+			g_atomic_int_inc( &g_nBrushBuildUnusedPlanes );
+		}
+		else{
+			Sys_FPrintf( SYS_WRN, "unused plane\n" );
+		}
 	}
 
 	return w;
@@ -852,6 +869,8 @@ void Brush_SnapPlanepts( brush_t *b ){
 	}
 }
 
+static void Brush_BuildFinish( brush_t *b, bool bMarkMap, bool bFilterTest );
+
 /*
 ** Brush_Build
 **
@@ -889,10 +908,25 @@ void Brush_Build( brush_t *b, bool bSnap, bool bMarkMap, bool bConvert, bool bFi
 	*/
 	Brush_BuildWindings( b, bSnap );
 
+	Brush_BuildFinish( b, bMarkMap, bFilterTest );
+
+	if ( bLocalConvert ) {
+		g_qeglobals.bNeedConvert = false;
+	}
+}
+
+/*
+** Brush_BuildFinish
+**
+** the part of Brush_Build that runs after the windings are built
+** touches the UI (group tree, map modified flag), so it must stay on the main thread
+*/
+static void Brush_BuildFinish( brush_t *b, bool bMarkMap, bool bFilterTest ){
 	if ( b->owner->model.pRender ) {
 		const aabb_t *aabb = b->owner->model.pRender->GetAABB();
 		VectorAdd( aabb->origin, aabb->extents, b->maxs );
 		VectorSubtract( aabb->origin, aabb->extents, b->mins );
+		XY_InvalidateBrush( b );
 	}
 
 	//Patch_BuildPoints (b); // does nothing but set b->patchBrush true if the texdef contains SURF_PATCH !
@@ -912,16 +946,120 @@ void Brush_Build( brush_t *b, bool bSnap, bool bMarkMap, bool bConvert, bool bFi
 		Sys_MarkMapModified();
 	}
 
-	if ( bLocalConvert ) {
-		g_qeglobals.bNeedConvert = false;
-	}
-
 	// spog - applying filters to brush during brush_build instead of during redraw
 	if ( bFilterTest ) {
 		b->bFiltered = FilterBrush( b );
 	}
 }
 
+/*
+** Brush_BuildList
+**
+** Brush_Build for a whole array of brushes, used when loading maps
+** shaders are bound serially, the planes, windings and texture coordinates are built
+** on worker threads, then grouping, filtering and the map modified flag are done serially
+** falls back to Brush_Build when converting texture formats (conversion code is not thread safe)
+*/
+#define BRUSH_BUILD_MIN_THREADED    256
+#define BRUSH_BUILD_MAX_THREADS     16
+
+typedef struct brushBuildWork_s
+{
+	brush_t **brushes;
+	int numBrushes;
+	int first, step;
+	bool bSnap;
+} brushBuildWork_t;
+
+static gpointer Brush_BuildWindingsWorker( gpointer data ){
+	brushBuildWork_t *work = (brushBuildWork_t *)data;
+
+	// interleave the brushes so every worker gets a mix of small and large entities
+	for ( int i = work->first; i < work->numBrushes; i += work->step )
+		Brush_BuildWindings( work->brushes[i], work->bSnap );
+
+	return NULL;
+}
+
+void Brush_BuildList( brush_t **brushes, int numBrushes, bool bSnap, bool bMarkMap, bool bFilterTest ){
+	brushBuildWork_t work[BRUSH_BUILD_MAX_THREADS];
+	GThread *threads[BRUSH_BUILD_MAX_THREADS];
+	face_t *f;
+	int i, numThreads;
+
+	// bind the shaders first, shader lookups may load textures
+	for ( i = 0; i < numBrushes; i++ )
+	{
+		for ( f = brushes[i]->brush_faces; f != NULL; f = f->next )
+		{
+			if ( !f->pShader ) {
+				f->pShader = QERApp_Shader_ForName( f->texdef.GetName() );
+				f->pShader->IncRef();
+				f->d_texture = f->pShader->getTexture();
+			}
+		}
+	}
+
+#if GLIB_CHECK_VERSION( 2, 36, 0 )
+	numThreads = g_get_num_processors();
+#else
+	numThreads = 4;
+#endif
+	if ( numThreads > BRUSH_BUILD_MAX_THREADS ) {
+		numThreads = BRUSH_BUILD_MAX_THREADS;
+	}
+
+	if ( g_qeglobals.bNeedConvert || numThreads < 2 || numBrushes < BRUSH_BUILD_MIN_THREADED ) {
+		for ( i = 0; i < numBrushes; i++ )
+			Brush_Build( brushes[i], bSnap, bMarkMap, false, bFilterTest );
+		return;
+	}
+
+	Brush_SetBuildWindingsThreaded( true );
+
+	// the main thread is worker 0
+	for ( i = 0; i < numThreads; i++ )
+	{
+		work[i].brushes = brushes;
+		work[i].numBrushes = numBrushes;
+		work[i].first = i;
+		work[i].step = numThreads;
+		work[i].bSnap = bSnap;
+		threads[i] = NULL;
+		if ( i == 0 ) {
+			continue;
+		}
+#if GLIB_CHECK_VERSION( 2, 32, 0 )
+		threads[i] = g_thread_try_new( "brush build", Brush_BuildWindingsWorker, &work[i], NULL );
+#else
+		threads[i] = g_thread_create( Brush_BuildWindingsWorker, &work[i], TRUE, NULL );
+#endif
+		if ( !threads[i] ) {
+			// could not spawn, do this share on the main thread
+			Brush_BuildWindingsWorker( &work[i] );
+		}
+	}
+	Brush_BuildWindingsWorker( &work[0] );
+	for ( i = 1; i < numThreads; i++ )
+	{
+		if ( threads[i] ) {
+			g_thread_join( threads[i] );
+		}
+	}
+
+	Brush_SetBuildWindingsThreaded( false );
+
+	for ( i = 0; i < numBrushes; i++ )
+	{
+		XY_InvalidateBrush( brushes[i] );
+		Brush_BuildFinish( brushes[i], false, bFilterTest );
+	}
+
+	if ( bMarkMap ) {
+		Sys_MarkMapModified();
+	}
+}
+
 /*
    ==============
    Brush_SplitBrushByFace
@@ -1922,7 +2060,9 @@ void Brush_Free( brush_t *b, bool bRemoveNode ){
 		Entity_UnlinkBrush( b );
 	}
 
-	free( b );
+	XY_FreeBrushCache( b );
+
+	Brush_Dealloc( b );
 }
 
 /*
@@ -2349,6 +2489,10 @@ void    Brush_AddToList( brush_t *b, brush_t *blist ){
 	blist->next = b;
 	b->prev = blist;
 
+	if ( blist == &active_brushes ) {
+		XY_InvalidateIndex();
+	}
+
 	// TTimo messaging
 	DispatchRadiantMsg( RADIANT_SELECTION );
 }
@@ -2364,6 +2508,8 @@ void    Brush_RemoveFromList( brush_t *b ){
 	b->next->prev = b->prev;
 	b->prev->next = b->next;
 	b->next = b->prev = NULL;
+
+	XY_InvalidateIndex();
 }
 
 /*
@@ -2674,7 +2820,7 @@ void Brush_SelectFaceForDragging( brush_t *b, face_t *f, qboolean shear ){
 			VectorCopy( w->points[i], f2->planepts[2] );
 		}
 
-		free( w );
+		Winding_Free( w );
 	}
 }
 
@@ -2725,6 +2871,21 @@ void Brush_SetBuildWindingsNoTexBuild( bool bBuild ){
 	g_bBuildWindingsNoTexBuild = bBuild;
 }
 
+// set while Brush_BuildWindings runs on worker threads: the console and the 2D view index are left alone
+// the unused planes counted meanwhile are reported once when the flag is cleared
+void Brush_SetBuildWindingsThreaded( bool bThreaded ){
+	if ( bThreaded ) {
+		g_nBrushBuildUnusedPlanes = 0;
+		g_bBrushBuildThreaded = true;
+		return;
+	}
+
+	g_bBrushBuildThreaded = false;
+	if ( g_nBrushBuildUnusedPlanes ) {
+		Sys_FPrintf( SYS_WRN, "%d unused planes\n", g_nBrushBuildUnusedPlanes );
+	}
+}
+
 // TTimo: don't rebuild pShader and d_texture if it doesn't seem necessary
 //    saves quite a lot of time, but on the other hand we've gotta make sure we clean the d_texture in some cases
 //    ie when we want to update a shader
@@ -2751,7 +2912,7 @@ void Brush_BuildWindings( brush_t *b, bool bSnap ){
 	for ( ; face ; face = face->next )
 	{
 		int i, j;
-		free( face->face_winding );
+		Winding_Free( face->face_winding );
 		w = face->face_winding = Brush_MakeFaceWinding( b, face );
 
 		if ( !g_bBuildWindingsNoTexBuild || !face->d_texture ) {
@@ -2837,6 +2998,11 @@ void Brush_BuildWindings( brush_t *b, bool bSnap ){
 				EmitTextureCoordinates( w->points[i], face->d_texture, face );
 		}
 	}
+
+	// the 2D views drop the cached outline, Brush_BuildList does this after its workers are done
+	if ( !g_bBrushBuildThreaded ) {
+		XY_InvalidateBrush( b );
+	}
 }
 
 /*
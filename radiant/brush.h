@@ -27,7 +27,9 @@ extern bool g_bBuildWindingsNoTexBuild;
 
 void        Brush_AddToList( brush_t *b, brush_t *lst );
 void        Brush_Build( brush_t *b, bool bSnap = true, bool bMarkMap = true, bool bConvert = false, bool bFilterTest = true );
+void        Brush_BuildList( brush_t **brushes, int numBrushes, bool bSnap = true, bool bMarkMap = true, bool bFilterTest = true );
 void    Brush_SetBuildWindingsNoTexBuild( bool bBuild );
+void    Brush_SetBuildWindingsThreaded( bool bThreaded );
 void        Brush_BuildWindings( brush_t *b, bool bSnap = true );
 brush_t*    Brush_Clone( brush_t *b );
 brush_t*    Brush_FullClone( brush_t *b );
@@ -83,6 +85,7 @@ void Brush_FitTexture( brush_t *b, int nHeight, int nWidth );
 //void Brush_SetEpair(brush_t *b, const char *pKey, const char *pValue);
 //const char* Brush_GetKeyValue(brush_t *b, const char *pKey);
 brush_t *Brush_Alloc();
+void Brush_Dealloc( brush_t *b );
 const char* Brush_Name( brush_t *b );
 
 //eclass_t* HasModel(brush_t *b);
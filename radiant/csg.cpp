@@ -74,6 +74,116 @@ void CSG_MakeHollow( void ){
 	Sys_UpdateWindows( W_ALL );
 }
 
+/*
+   =============
+   CSG_CloneBrush
+
+   CSG_Subtract builds its fragments on worker threads, so the brushes it works on are bare:
+   they are not linked to an entity or the group tree, and their faces borrow the shader of
+   the face they were cloned from without taking a reference.
+   CSG_FinishFragment turns a bare brush into a regular one on the main thread.
+   =============
+ */
+static brush_t *CSG_CloneBrush( brush_t *b ){
+	brush_t *n;
+	face_t  *f, *nf;
+
+	n = Brush_Alloc();
+	n->owner = b->owner;
+	for ( f = b->brush_faces ; f ; f = f->next )
+	{
+		nf = Face_Clone( f );
+		nf->pShader = f->pShader;
+		nf->d_texture = f->d_texture;
+		nf->next = n->brush_faces;
+		n->brush_faces = nf;
+	}
+
+	return n;
+}
+
+static void CSG_FreeBrush( brush_t *b ){
+	face_t  *f, *next;
+
+	for ( f = b->brush_faces ; f ; f = next )
+	{
+		next = f->next;
+		Face_Free( f );
+	}
+	Brush_Dealloc( b );
+}
+
+static void CSG_FinishFragment( brush_t *b, entity_t *owner ){
+	face_t  *f;
+
+	// drop the borrowed shaders, Brush_Build binds and references them
+	for ( f = b->brush_faces ; f ; f = f->next )
+	{
+		f->pShader = NULL;
+		f->d_texture = NULL;
+	}
+	b->numberId = g_nBrushId++;
+	Entity_LinkBrush( owner, b );
+	Brush_Build( b, false, false );
+}
+
+/*
+   =============
+   CSG_SplitBrush
+
+   Brush_SplitBrushByFace for bare brushes, safe to call from the CSG_Subtract workers.
+   The incoming brush is NOT freed.
+   =============
+ */
+static void CSG_SplitBrush( brush_t *in, face_t *f, brush_t **front, brush_t **back ){
+	brush_t *b;
+	face_t  *nf;
+	vec3_t temp;
+
+	b = CSG_CloneBrush( in );
+	nf = Face_Clone( f );
+	nf->texdef = b->brush_faces->texdef;
+	nf->pShader = b->brush_faces->pShader;
+	nf->d_texture = b->brush_faces->d_texture;
+	nf->next = b->brush_faces;
+	b->brush_faces = nf;
+
+	Brush_BuildWindings( b, true );
+	Brush_RemoveEmptyFaces( b );
+	if ( !b->brush_faces ) { // completely clipped away
+		CSG_FreeBrush( b );
+		*back = NULL;
+	}
+	else
+	{
+		*back = b;
+	}
+
+	b = CSG_CloneBrush( in );
+	nf = Face_Clone( f );
+	// swap the plane winding
+	VectorCopy( nf->planepts[0], temp );
+	VectorCopy( nf->planepts[1], nf->planepts[0] );
+	VectorCopy( temp, nf->planepts[1] );
+
+	nf->texdef = b->brush_faces->texdef;
+	nf->pShader = b->brush_faces->pShader;
+	nf->d_texture = b->brush_faces->d_texture;
+	nf->next = b->brush_faces;
+	b->brush_faces = nf;
+
+	Brush_BuildWindings( b, true );
+	Brush_RemoveEmptyFaces( b );
+	if ( !b->brush_faces ) { // completely clipped away
+		CSG_FreeBrush( b );
+		*front = NULL;
+	}
+	else
+	{
+		*front = b;
+	}
+}
+
 /*
    =============
    Brush_Merge
@@ -85,6 +195,8 @@ void CSG_MakeHollow( void ){
    if onlyshape is true then the merge is allowed based on the shape only
    otherwise the texture/shader references of faces in the same plane have to
    be the same as well.
+
+   Works on bare brushes (see CSG_CloneBrush), the new brush is bare as well.
    =============
  */
 brush_t *Brush_Merge( brush_t *brush1, brush_t *brush2, int onlyshape ){
@@ -186,6 +298,8 @@ brush_t *Brush_Merge( brush_t *brush1, brush_t *brush2, int onlyshape ){
 		VectorCopy( face1->planepts[1], newface->planepts[1] );
 		VectorCopy( face1->planepts[2], newface->planepts[2] );
 		newface->plane = face1->plane;
+		newface->pShader = face1->pShader;
+		newface->d_texture = face1->d_texture;
 		newface->next = newbrush->brush_faces;
 		newbrush->brush_faces = newface;
 	}
@@ -222,11 +336,12 @@ brush_t *Brush_Merge( brush_t *brush1, brush_t *brush2, int onlyshape ){
 		VectorCopy( face2->planepts[1], newface->planepts[1] );
 		VectorCopy( face2->planepts[2], newface->planepts[2] );
 		newface->plane = face2->plane;
+		newface->pShader = face2->pShader;
+		newface->d_texture = face2->d_texture;
 		newface->next = newbrush->brush_faces;
 		newbrush->brush_faces = newface;
 	}
-	// link the new brush to an entity
-	Entity_LinkBrush( brush1->owner, newbrush );
+	newbrush->owner = brush1->owner;
 	// build windings for the faces
 	Brush_BuildWindings( newbrush, false );
 
@@ -240,7 +355,7 @@ brush_t *Brush_Merge( brush_t *brush1, brush_t *brush2, int onlyshape ){
    Returns a list with merged brushes.
    Tries to merge brushes pair wise.
    The input list is destroyed.
-   Input and output should be a single linked list using .next
+   Input and output should be a single linked list using .next of bare brushes
    =============
  */
 brush_t *Brush_MergeListPairs( brush_t *brushlist, int onlyshape ){
@@ -275,8 +390,8 @@ brush_t *Brush_MergeListPairs( brush_t *brushlist, int onlyshape ){
 					brushlist = brushlist->next;
 					b1->next = b1->prev = NULL;
 					b2->next = b2->prev = NULL;
-					Brush_Free( b1 );
-					Brush_Free( b2 );
+					CSG_FreeBrush( b1 );
+					CSG_FreeBrush( b2 );
 					for ( tail = brushlist; tail; tail = tail->next )
 					{
 						if ( !tail->next ) {
@@ -457,6 +572,7 @@ brush_t *Brush_MergeList( brush_t *brushlist, int onlyshape ){
    Returns a list of brushes that remain after B is subtracted from A.
    May by empty if A is contained inside B.
    The originals are undisturbed.
+   The returned fragments are bare brushes (see CSG_CloneBrush).
    =============
  */
 brush_t *Brush_Subtract( brush_t *a, brush_t *b ){
@@ -469,9 +585,9 @@ brush_t *Brush_Subtract( brush_t *a, brush_t *b ){
 	out = NULL;
 	for ( f = b->brush_faces; f && in; f = f->next )
 	{
-		Brush_SplitBrushByFace( in, f, &front, &back );
+		CSG_SplitBrush( in, f, &front, &back );
 		if ( in != a ) {
-			Brush_Free( in );
+			CSG_FreeBrush( in );
 		}
 		if ( front ) { // add to list
 			front->next = out;
@@ -481,15 +597,14 @@ brush_t *Brush_Subtract( brush_t *a, brush_t *b ){
 	}
 	//NOTE: in != a just in case brush b has no faces
 	if ( in && in != a ) {
-		Brush_Free( in );
+		CSG_FreeBrush( in );
 	}
 	else
 	{   //didn't really intersect
 		for ( b = out; b; b = next )
 		{
 			next = b->next;
-			b->next = b->prev = NULL;
-			Brush_Free( b );
+			CSG_FreeBrush( b );
 		}
 		return a;
 	}
@@ -499,12 +614,184 @@ brush_t *Brush_Subtract( brush_t *a, brush_t *b ){
 /*
    =============
    CSG_Subtract
+
+   Every selected brush is subtracted from the active brushes it overlaps.
+   A sweep over the lower x bounds of the selection finds the overlapping pairs,
+   then each chopped brush is independent of the others, so the fragments are built
+   on worker threads. Undo and the brush lists are only touched on the main thread,
+   in active list order, so the result does not depend on the thread timing.
+   Each chopped brush goes through the same cuts and merges as in the old per-cutter
+   loop, so the fragments are the same, but they are grouped per chopped brush and
+   end up in a different order in the active list and the undo record.
    =============
  */
+#define CSG_SUBTRACT_MIN_THREADED   8
+#define CSG_SUBTRACT_MAX_THREADS    16
+
+typedef struct csgCutter_s
+{
+	float mins;
+	int index;
+} csgCutter_t;
+
+typedef struct csgTarget_s
+{
+	brush_t *brush;
+	int firstCutter, numCutters;    // into the candidate array, in selection order
+	bool bChopped;
+	brush_t *fragments;             // bare brushes
+} csgTarget_t;
+
+typedef struct csgSubtractWork_s
+{
+	csgTarget_t *targets;
+	int numTargets;
+	brush_t **cutters;
+	int *candidates;
+	int first, step;
+} csgSubtractWork_t;
+
+static bool CSG_BoundsOverlap( brush_t *b, brush_t *s ){
+	for ( int i = 0 ; i < 3 ; i++ )
+		if ( b->mins[i] >= s->maxs[i] - ON_EPSILON
+			 || b->maxs[i] <= s->mins[i] + ON_EPSILON ) {
+			return false;   // definately don't touch
+		}
+	return true;
+}
+
+static int CSG_CompareCutters( const void *a, const void *b ){
+	const csgCutter_t *ca = (const csgCutter_t *)a;
+	const csgCutter_t *cb = (const csgCutter_t *)b;
+
+	if ( ca->mins != cb->mins ) {
+		return ( ca->mins < cb->mins ) ? -1 : 1;
+	}
+	return ca->index - cb->index;
+}
+
+static int CSG_CompareInts( const void *a, const void *b ){
+	return *(const int *)a - *(const int *)b;
+}
+
+static void CSG_SubtractTarget( csgTarget_t *t, brush_t **cutters, int *candidates ){
+	brush_t *b, *s, *next, *fragments, *frag, *kept, **tail;
+	int i;
+
+	for ( i = 0; i < t->numCutters; i++ )
+	{
+		b = cutters[candidates[t->firstCutter + i]];
+
+		// chop the brush itself
+		if ( !t->bChopped ) {
+			fragments = Brush_Subtract( t->brush, b );
+			// if the brushes did not really intersect
+			if ( fragments == t->brush ) {
+				continue;
+			}
+			t->bChopped = true;
+			// try to merge fragments
+			t->fragments = Brush_MergeListPairs( fragments, true );
+			continue;
+		}
+
+		// chop its fragments further up
+		kept = NULL;
+		tail = &kept;
+		for ( s = t->fragments; s; s = next )
+		{
+			next = s->next;
+			s->next = NULL;
+
+			fragments = s;
+			if ( CSG_BoundsOverlap( b, s ) ) {
+				fragments = Brush_Subtract( s, b );
+				if ( fragments != s ) {
+					CSG_FreeBrush( s );
+					fragments = Brush_MergeListPairs( fragments, true );
+				}
+			}
+
+			*tail = fragments;
+			for ( frag = fragments; frag; frag = frag->next )
+				tail = &frag->next;
+		}
+		t->fragments = kept;
+	}
+}
+
+static gpointer CSG_SubtractWorker( gpointer data ){
+	csgSubtractWork_t *work = (csgSubtractWork_t *)data;
+
+	for ( int i = work->first; i < work->numTargets; i += work->step )
+		CSG_SubtractTarget( &work->targets[i], work->cutters, work->candidates );
+
+	return NULL;
+}
+
+static void CSG_SubtractTargets( csgTarget_t *targets, int numTargets, brush_t **cutters, int *candidates ){
+	csgSubtractWork_t work[CSG_SUBTRACT_MAX_THREADS];
+	GThread *threads[CSG_SUBTRACT_MAX_THREADS];
+	int i, numThreads;
+
+#if GLIB_CHECK_VERSION( 2, 36, 0 )
+	numThreads = g_get_num_processors();
+#else
+	numThreads = 4;
+#endif
+	if ( numThreads > CSG_SUBTRACT_MAX_THREADS ) {
+		numThreads = CSG_SUBTRACT_MAX_THREADS;
+	}
+	// texture format conversion is not thread safe
+	if ( g_qeglobals.bNeedConvert || numTargets < CSG_SUBTRACT_MIN_THREADED ) {
+		numThreads = 1;
+	}
+
+	Brush_SetBuildWindingsThreaded( true );
+
+	// the main thread is worker 0
+	for ( i = 0; i < numThreads; i++ )
+	{
+		work[i].targets = targets;
+		work[i].numTargets = numTargets;
+		work[i].cutters = cutters;
+		work[i].candidates = candidates;
+		work[i].first = i;
+		work[i].step = numThreads;
+		threads[i] = NULL;
+		if ( i == 0 ) {
+			continue;
+		}
+#if GLIB_CHECK_VERSION( 2, 32, 0 )
+		threads[i] = g_thread_try_new( "csg subtract", CSG_SubtractWorker, &work[i], NULL );
+#else
+		threads[i] = g_thread_create( CSG_SubtractWorker, &work[i], TRUE, NULL );
+#endif
+		if ( !threads[i] ) {
+			// could not spawn, do this share on the main thread
+			CSG_SubtractWorker( &work[i] );
+		}
+	}
+	CSG_SubtractWorker( &work[0] );
+	for ( i = 1; i < numThreads; i++ )
+	{
+		if ( threads[i] ) {
+			g_thread_join( threads[i] );
+		}
+	}
+
+	Brush_SetBuildWindingsThreaded( false );
+}
+
 void CSG_Subtract( void ){
-	brush_t     *b, *s, *fragments, *nextfragment, *frag, *next, *snext;
+	brush_t     *b, *s, *frag, *nextfragment;
 	brush_t fragmentlist;
-	int i, numfragments, numbrushes;
+	csgCutter_t *sorted;
+	csgTarget_t *targets, *t;
+	brush_t     **cutters;
+	GArray      *candidates;
+	float maxSize;
+	int i, lo, hi, mid, numCutters, numTargets, numfragments, numbrushes;
 
 	Sys_Printf( "Subtracting...\n" );
 
@@ -513,97 +800,115 @@ void CSG_Subtract( void ){
 		return;
 	}
 
-	fragmentlist.next = &fragmentlist;
-	fragmentlist.prev = &fragmentlist;
+	// gather the cutters in selection order
+	numCutters = 0;
+	for ( b = selected_brushes.next ; b != &selected_brushes ; b = b->next )
+		numCutters++;
+	cutters = g_new( brush_t *, numCutters );
+	sorted = g_new( csgCutter_t, numCutters );
 
-	numfragments = 0;
-	numbrushes = 0;
-	for ( b = selected_brushes.next ; b != &selected_brushes ; b = next )
+	numCutters = 0;
+	maxSize = 0;
+	for ( b = selected_brushes.next ; b != &selected_brushes ; b = b->next )
 	{
-		next = b->next;
-
 		if ( b->owner->eclass->fixedsize ) {
 			continue;   // can't use texture from a fixed entity, so don't subtract
+		}
+		sorted[numCutters].mins = b->mins[0];
+		sorted[numCutters].index = numCutters;
+		if ( b->maxs[0] - b->mins[0] > maxSize ) {
+			maxSize = b->maxs[0] - b->mins[0];
+		}
+		cutters[numCutters++] = b;
+	}
+	qsort( sorted, numCutters, sizeof( csgCutter_t ), CSG_CompareCutters );
 
+	// find the cutters overlapping each active brush
+	numTargets = 0;
+	for ( s = active_brushes.next; s != &active_brushes; s = s->next )
+		numTargets++;
+	targets = g_new0( csgTarget_t, numTargets );
+	candidates = g_array_new( FALSE, FALSE, sizeof( int ) );
+
+	numTargets = 0;
+	for ( s = active_brushes.next; s != &active_brushes; s = s->next )
+	{
+		if ( s->owner->eclass->fixedsize || s->patchBrush || s->bFiltered ) {
+			continue;
 		}
-		// chop all fragments further up
-		for ( s = fragmentlist.next; s != &fragmentlist; s = snext )
-		{
-			snext = s->next;
 
-			for ( i = 0 ; i < 3 ; i++ )
-				if ( b->mins[i] >= s->maxs[i] - ON_EPSILON
-					 || b->maxs[i] <= s->mins[i] + ON_EPSILON ) {
-					break;
-				}
-			if ( i != 3 ) {
-				continue;   // definately don't touch
-			}
-			fragments = Brush_Subtract( s, b );
-			// if the brushes did not really intersect
-			if ( fragments == s ) {
-				continue;
+		if ( s->brush_faces->pShader->getFlags() & QER_NOCARVE ) {
+			continue;
+		}
+
+		// first cutter that can reach s on x
+		lo = 0;
+		hi = numCutters;
+		while ( lo < hi )
+		{
+			mid = ( lo + hi ) / 2;
+			if ( sorted[mid].mins + maxSize <= s->mins[0] + ON_EPSILON ) {
+				lo = mid + 1;
 			}
-			// try to merge fragments
-			fragments = Brush_MergeListPairs( fragments, true );
-			// add the fragments to the list
-			for ( frag = fragments; frag; frag = nextfragment )
-			{
-				nextfragment = frag->next;
-				frag->next = NULL;
-				frag->owner = s->owner;
-				Brush_AddToList( frag, &fragmentlist );
+			else{
+				hi = mid;
 			}
-			// free the original brush
-			Brush_Free( s );
 		}
 
-		// chop any active brushes up
-		for ( s = active_brushes.next; s != &active_brushes; s = snext )
+		t = &targets[numTargets];
+		t->brush = s;
+		t->firstCutter = candidates->len;
+		for ( i = lo; i < numCutters && sorted[i].mins < s->maxs[0] - ON_EPSILON; i++ )
 		{
-			snext = s->next;
-
-			if ( s->owner->eclass->fixedsize || s->patchBrush || s->bFiltered ) {
-				continue;
+			if ( CSG_BoundsOverlap( cutters[sorted[i].index], s ) ) {
+				g_array_append_val( candidates, sorted[i].index );
 			}
+		}
+		t->numCutters = candidates->len - t->firstCutter;
+		if ( !t->numCutters ) {
+			continue;
+		}
 
-			if ( s->brush_faces->pShader->getFlags() & QER_NOCARVE ) {
-				continue;
-			}
+		// the cutters are applied in selection order
+		qsort( &g_array_index( candidates, int, t->firstCutter ), t->numCutters, sizeof( int ), CSG_CompareInts );
+		numTargets++;
+	}
 
-			for ( i = 0 ; i < 3 ; i++ )
-				if ( b->mins[i] >= s->maxs[i] - ON_EPSILON
-					 || b->maxs[i] <= s->mins[i] + ON_EPSILON ) {
-					break;
-				}
-			if ( i != 3 ) {
-				continue;   // definately don't touch
+	CSG_SubtractTargets( targets, numTargets, cutters, (int *)candidates->data );
 
-			}
-			fragments = Brush_Subtract( s, b );
-			// if the brushes did not really intersect
-			if ( fragments == s ) {
-				continue;
-			}
-			//
-			Undo_AddBrush( s );
-			// one extra brush chopped up
-			numbrushes++;
-			// try to merge fragments
-			fragments = Brush_MergeListPairs( fragments, true );
-			// add the fragments to the list
-			for ( frag = fragments; frag; frag = nextfragment )
-			{
-				nextfragment = frag->next;
-				frag->next = NULL;
-				frag->owner = s->owner;
-				Brush_AddToList( frag, &fragmentlist );
-			}
-			// free the original brush
-			Brush_Free( s );
+	fragmentlist.next = &fragmentlist;
+	fragmentlist.prev = &fragmentlist;
+
+	numfragments = 0;
+	numbrushes = 0;
+	for ( i = 0; i < numTargets; i++ )
+	{
+		t = &targets[i];
+		if ( !t->bChopped ) {
+			continue;
 		}
+		s = t->brush;
+
+		Undo_AddBrush( s );
+		// one extra brush chopped up
+		numbrushes++;
+		// add the fragments to the list
+		for ( frag = t->fragments; frag; frag = nextfragment )
+		{
+			nextfragment = frag->next;
+			frag->next = NULL;
+			CSG_FinishFragment( frag, s->owner );
+			Brush_AddToList( frag, &fragmentlist );
+		}
+		// free the original brush
+		Brush_Free( s );
 	}
 
+	g_array_free( candidates, TRUE );
+	g_free( targets );
+	g_free( sorted );
+	g_free( cutters );
+
 	// move all fragments to the active brush list
 	for ( frag = fragmentlist.next; frag != &fragmentlist; frag = nextfragment )
 	{
@@ -614,6 +919,10 @@ void CSG_Subtract( void ){
 		Undo_EndBrush( frag );
 	}
 
+	if ( numbrushes ) {
+		Sys_MarkMapModified();
+	}
+
 	/*if (numfragments == 0)
 	   {
 	    Sys_Printf("Selected brush%s did not intersect with any other brushes.\n",
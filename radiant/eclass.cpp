@@ -34,6 +34,11 @@ char eclass_directory[1024];
 qboolean parsing_single = false;
 eclass_t *eclass_e;
 
+// name -> eclass_t, for Eclass_ForName. first one inserted wins, as with the list walk
+static GHashTable *eclass_hash = NULL;
+// where the last Eclass_InsertAlphabetized went, definition files are mostly sorted already
+static eclass_t *eclass_insert_hint = NULL;
+
 /*!
    implementation of the EClass manager API
  */
@@ -105,6 +110,11 @@ void CleanEntityList( eclass_t *&pList ){
 
 void CleanUpEntities(){
 	// NOTE: maybe some leak checks needed .. older versions of Radiant looked like they were freezing more stuff
+	if ( eclass_hash ) {
+		g_hash_table_destroy( eclass_hash );
+		eclass_hash = NULL;
+	}
+	eclass_insert_hint = NULL;
 	CleanEntityList( eclass );
 	//CleanEntityList(g_md3Cache);
 	if ( eclass_bad ) {
@@ -149,7 +159,27 @@ void EClass_InsertSortedList( eclass_t *&pList, eclass_t *e ){
  */
 void Eclass_InsertAlphabetized( eclass_t *e ){
 #if 1
-	EClass_InsertSortedList( eclass, e );
+	// everything up to the hint sorts before e, so the walk can start there
+	// (same position as walking from the head, ties still go after the existing ones)
+	if ( eclass_insert_hint && stricmp( e->name, eclass_insert_hint->name ) >= 0 ) {
+		eclass_t *s = eclass_insert_hint;
+		while ( s->next && stricmp( e->name, s->next->name ) >= 0 )
+			s = s->next;
+		e->next = s->next;
+		s->next = e;
+	}
+	else
+	{
+		EClass_InsertSortedList( eclass, e );
+	}
+	eclass_insert_hint = e;
+
+	if ( !eclass_hash ) {
+		eclass_hash = g_hash_table_new( g_str_hash, g_str_equal );
+	}
+	if ( !g_hash_table_lookup( eclass_hash, e->name ) ) {
+		g_hash_table_insert( eclass_hash, e->name, e );
+	}
 #else
 	eclass_t    *s;
 
@@ -347,6 +377,7 @@ void Eclass_Init(){
 		// read in all scripts/*.<extension>
 		pFiles = vfsGetFileList( "scripts", pTable->m_pfnGetExtension() );
 		if ( pFiles ) {
+			GPtrArray *fullpaths = g_ptr_array_new();
 			GSList *pFile = pFiles;
 			while ( pFile )
 			{
@@ -410,7 +441,7 @@ void Eclass_Init(){
 					Sys_FPrintf( SYS_ERR, "Failed to find the full path for \"%s\" in the VFS\n", relPath );
 				}
 				else{
-					pTable->m_pfnScanFile( fullpath );
+					g_ptr_array_add( fullpaths, g_strdup( fullpath ) );
 				}
 				if ( g_pGameDescription->mEClassSingleLoad ) {
 					break;
@@ -419,6 +450,19 @@ void Eclass_Init(){
 			}
 			vfsClearFileDirList( &pFiles );
 			pFiles = NULL;
+
+			// the builtin .def loader can parse the files concurrently, plugin loaders go one by one
+			if ( pTable->m_pfnScanFile == &Eclass_ScanFile ) {
+				Eclass_ScanFiles( (char **)fullpaths->pdata, fullpaths->len );
+			}
+			else
+			{
+				for ( unsigned int i = 0; i < fullpaths->len; i++ )
+					pTable->m_pfnScanFile( (char *)g_ptr_array_index( fullpaths, i ) );
+			}
+			for ( unsigned int i = 0; i < fullpaths->len; i++ )
+				g_free( g_ptr_array_index( fullpaths, i ) );
+			g_ptr_array_free( fullpaths, TRUE );
 		}
 		else{
 			Sys_FPrintf( SYS_ERR, "Didn't find any scripts/*.%s files to load EClass information\n", pTable->m_pfnGetExtension() );
@@ -453,10 +497,12 @@ eclass_t *Eclass_ForName( const char *name, qboolean has_brushes ){
 		return eclass_bad;
 	}
 
-	for ( e = eclass ; e ; e = e->next )
-		if ( !strcmp( name, e->name ) ) {
+	if ( eclass_hash ) {
+		e = (eclass_t *)g_hash_table_lookup( eclass_hash, name );
+		if ( e ) {
 			return e;
 		}
+	}
 
 	// create a new class for it
 	if ( has_brushes ) {
@@ -121,6 +121,79 @@ void setSpecialLoad( eclass_t *e, const char* pWhat, char*& p ){
 	}
 }
 
+/*!
+   COM_Parse with the token in a caller buffer (MAX_ECLASS_TOKEN long) instead of the global com_token,
+   so definition files can be parsed on worker threads (see Eclass_ScanFiles)
+ */
+#define MAX_ECLASS_TOKEN 1024
+
+static char *Eclass_ParseToken( char *data, char *token ){
+	int c;
+	int len;
+
+	len = 0;
+	token[0] = 0;
+
+	if ( !data ) {
+		return NULL;
+	}
+
+// skip whitespace
+skipwhite:
+	while ( ( c = *data ) <= ' ' )
+	{
+		if ( c == 0 ) {
+			return NULL;            // end of file;
+		}
+		data++;
+	}
+
+// skip // comments
+	if ( c == '/' && data[1] == '/' ) {
+		while ( *data && *data != '\n' )
+			data++;
+		goto skipwhite;
+	}
+
+// handle quoted strings specially
+	if ( c == '\"' ) {
+		data++;
+		while ( len < MAX_ECLASS_TOKEN - 1 )
+		{
+			c = *data++;
+			if ( c == '\"' || c == 0 ) {
+				break;
+			}
+			token[len++] = c;
+		}
+		token[len] = 0;
+		return ( c == 0 ) ? data - 1 : data;
+	}
+
+// parse single characters
+	if ( c == '{' || c == '}' || c == ')' || c == '(' || c == '\'' || c == ':' ) {
+		token[len] = c;
+		len++;
+		token[len] = 0;
+		return data + 1;
+	}
+
+// parse a regular word
+	do
+	{
+		token[len] = c;
+		data++;
+		len++;
+		c = *data;
+		if ( c == '{' || c == '}' || c == ')' || c == '(' || c == '\'' || c == ':' ) {
+			break;
+		}
+	} while ( c > 32 && len < MAX_ECLASS_TOKEN - 1 );
+
+	token[len] = 0;
+	return data;
+}
+
 eclass_t *Eclass_InitFromText( char *text ){
 	char    *t;
 	int len;
@@ -128,6 +201,7 @@ eclass_t *Eclass_InitFromText( char *text ){
 	char parms[256], *p;
 	eclass_t    *e;
 	char color[128];
+	char token[MAX_ECLASS_TOKEN];
 
 	e = (eclass_t*)malloc( sizeof( *e ) );
 	memset( e, 0, sizeof( *e ) );
@@ -135,10 +209,9 @@ eclass_t *Eclass_InitFromText( char *text ){
 	text += strlen( "/*QUAKED " );
 
 	// grab the name
-	text = COM_Parse( text );
-	e->name = (char*)malloc( strlen( Get_COM_Token() ) + 1 );
-	strcpy( e->name, Get_COM_Token() );
-	debugname = e->name;
+	text = Eclass_ParseToken( text, token );
+	e->name = (char*)malloc( strlen( token ) + 1 );
+	strcpy( e->name, token );
 
 	// grab the color, reformat as texture name
 	r = sscanf( text," (%f %f %f)", &e->color[0], &e->color[1], &e->color[2] );
@@ -159,8 +232,8 @@ eclass_t *Eclass_InitFromText( char *text ){
 	text++;
 
 	// get the size
-	text = COM_Parse( text );
-	if ( Get_COM_Token()[0] == '(' ) { // parse the size as two vectors
+	text = Eclass_ParseToken( text, token );
+	if ( token[0] == '(' ) { // parse the size as two vectors
 		e->fixedsize = true;
 		r = sscanf( text,"%f %f %f) (%f %f %f)", &e->mins[0], &e->mins[1], &e->mins[2],
 					&e->maxs[0], &e->maxs[1], &e->maxs[2] );
@@ -194,11 +267,11 @@ eclass_t *Eclass_InitFromText( char *text ){
 	p = parms;
 	for ( i = 0 ; i < MAX_FLAGS ; i++ )
 	{
-		p = COM_Parse( p );
+		p = Eclass_ParseToken( p, token );
 		if ( !p ) {
 			break;
 		}
-		strcpy( e->flagnames[i], Get_COM_Token() );
+		strncpy( e->flagnames[i], token, sizeof( e->flagnames[i] ) - 1 );
 	}
 
 	// find the length until close comment
@@ -280,6 +353,7 @@ void Eclass_ScanFile( char *filename ){
 		if ( !strncmp( data + i, "/*QUAKED",8 ) ) {
 			e = Eclass_InitFromText( data + i );
 			if ( e ) {
+				debugname = e->name;
 				Eclass_InsertAlphabetized( e );
 			}
 			else{
@@ -297,3 +371,148 @@ void Eclass_ScanFile( char *filename ){
 
 	g_free( data );
 }
+
+/*!
+   Eclass_ScanFile for a list of files: the files are read and parsed on worker threads,
+   then the classes are inserted on the main thread in file order, so the result is the same
+   as scanning them one after the other
+ */
+#define ECLASS_SCAN_MAX_THREADS 8
+
+typedef struct eclassScanFile_s
+{
+	const char *filename;
+	int size;
+	GPtrArray *classes;
+} eclassScanFile_t;
+
+typedef struct eclassScanWork_s
+{
+	eclassScanFile_t *files;
+	int numFiles;
+	int first, step;
+} eclassScanWork_t;
+
+// must not touch the console or the eclass list
+static gpointer Eclass_ScanFilesWorker( gpointer data ){
+	eclassScanWork_t *work = (eclassScanWork_t *)data;
+
+	for ( int j = work->first; j < work->numFiles; j += work->step )
+	{
+		eclassScanFile_t *file = &work->files[j];
+		char *text;
+		FILE *f;
+
+		// same as vfsLoadFullPathFile, which is not ours to call from here
+		file->size = -1;
+		f = fopen( file->filename, "rb" );
+		if ( !f ) {
+			continue;
+		}
+		fseek( f, 0, SEEK_END );
+		file->size = ftell( f );
+		rewind( f );
+		text = (char *)g_malloc( file->size + 1 );
+		file->size = fread( text, 1, file->size, f );
+		fclose( f );
+		text[file->size] = 0;
+
+		for ( int i = 0 ; i < file->size ; i++ )
+		{
+			if ( !strncmp( text + i, "/*QUAKED", 8 ) ) {
+				g_ptr_array_add( file->classes, Eclass_InitFromText( text + i ) );
+			}
+		}
+		g_free( text );
+	}
+
+	return NULL;
+}
+
+void Eclass_ScanFiles( char **filenames, int numFiles ){
+	eclassScanWork_t work[ECLASS_SCAN_MAX_THREADS];
+	GThread *threads[ECLASS_SCAN_MAX_THREADS];
+	eclassScanFile_t *files;
+	int i, numThreads;
+	char temp[1024];
+
+	// single entity parsing stops at the first class, keep that path
+	if ( Get_Parsing_Single() || numFiles < 2 ) {
+		for ( i = 0; i < numFiles; i++ )
+			Eclass_ScanFile( filenames[i] );
+		return;
+	}
+
+	files = new eclassScanFile_t[numFiles];
+	for ( i = 0; i < numFiles; i++ )
+	{
+		files[i].filename = filenames[i];
+		files[i].size = -1;
+		files[i].classes = g_ptr_array_new();
+	}
+
+#if GLIB_CHECK_VERSION( 2, 36, 0 )
+	numThreads = g_get_num_processors();
+#else
+	numThreads = 4;
+#endif
+	if ( numThreads > ECLASS_SCAN_MAX_THREADS ) {
+		numThreads = ECLASS_SCAN_MAX_THREADS;
+	}
+	if ( numThreads > numFiles ) {
+		numThreads = numFiles;
+	}
+
+	// the main thread is worker 0
+	for ( i = 0; i < numThreads; i++ )
+	{
+		work[i].files = files;
+		work[i].numFiles = numFiles;
+		work[i].first = i;
+		work[i].step = numThreads;
+		threads[i] = NULL;
+		if ( i == 0 ) {
+			continue;
+		}
+#if GLIB_CHECK_VERSION( 2, 32, 0 )
+		threads[i] = g_thread_try_new( "eclass scan", Eclass_ScanFilesWorker, &work[i], NULL );
+#else
+		threads[i] = g_thread_create( Eclass_ScanFilesWorker, &work[i], TRUE, NULL );
+#endif
+		if ( !threads[i] ) {
+			Eclass_ScanFilesWorker( &work[i] );
+		}
+	}
+	Eclass_ScanFilesWorker( &work[0] );
+	for ( i = 1; i < numThreads; i++ )
+	{
+		if ( threads[i] ) {
+			g_thread_join( threads[i] );
+		}
+	}
+
+	// merge in file order
+	for ( i = 0; i < numFiles; i++ )
+	{
+		eclassScanFile_t *file = &files[i];
+		if ( file->size <= 0 ) {
+			Sys_FPrintf( SYS_ERR, "Eclass_ScanFile: %s not found\n", file->filename );
+		}
+		else
+		{
+			QE_ConvertDOSToUnixName( temp, file->filename );
+			Sys_Printf( "ScanFile: %s\n", temp );
+			eclass_found = false;
+			for ( unsigned int j = 0; j < file->classes->len; j++ )
+			{
+				eclass_t *e = (eclass_t *)g_ptr_array_index( file->classes, j );
+				debugname = e->name;
+				Eclass_InsertAlphabetized( e );
+				*Get_Eclass_E() = e;
+				Set_Eclass_Found( true );
+			}
+		}
+		g_ptr_array_free( file->classes, TRUE );
+	}
+	delete [] files;
+}
@@ -41,4 +41,8 @@ void EnumerateInterfaces( CSynapseServer *server );
 
 };
 
+// builtin .def loader, Eclass_ScanFiles parses several files concurrently
+void Eclass_ScanFile( char *filename );
+void Eclass_ScanFiles( char **filenames, int numFiles );
+
 #endif
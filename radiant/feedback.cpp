@@ -58,7 +58,7 @@ void CSelectMsg::saxCharacters( message_info_t *ctx, const xmlChar *ch, int len
 		message = g_string_sized_new( len + 1 );
 		memcpy( message->str, ch, len );
 		message->str[len] = '\0';
-		Sys_Printf( "%s\n", message->str );
+		WatchBSP_Printf( SYS_STD, "%s\n", message->str );
 	}
 	else
 	{
@@ -97,7 +97,7 @@ void CPointMsg::saxCharacters( message_info_t *ctx, const xmlChar *ch, int len )
 		message = g_string_sized_new( len + 1 );
 		memcpy( message->str, ch, len );
 		message->str[len] = '\0';
-		Sys_Printf( "%s\n", message->str );
+		WatchBSP_Printf( SYS_STD, "%s\n", message->str );
 	}
 	else
 	{
@@ -163,7 +163,7 @@ void CWindingMsg::saxCharacters( message_info_t *ctx, const xmlChar *ch, int len
 		message = g_string_sized_new( len + 1 );
 		memcpy( message->str, ch, len );
 		message->str[len] = '\0';
-		Sys_Printf( "%s\n", message->str );
+		WatchBSP_Printf( SYS_STD, "%s\n", message->str );
 	}
 	else
 	{
@@ -286,19 +286,25 @@ void CDbgDlg::Init() {
 }
 
 void CDbgDlg::Push( ISAXHandler *pHandler ) {
+	GtkTreeIter iter;
+	unsigned int i;
+
 	// push in the list
 	g_ptr_array_add( m_pFeedbackElements, (void *)pHandler );
 
 	if ( m_pWidget == NULL ) {
 		Create();
+		// put stuff in the new list
+		for ( i = 0; i < m_pFeedbackElements->len; i++ ) {
+			gtk_list_store_append( m_clist, &iter );
+			gtk_list_store_set( m_clist, &iter, 0, GetElement( i )->getName(), -1 );
+		}
 	}
-	// put stuff in the list
-	gtk_list_store_clear( m_clist );
-	unsigned int i;
-	for ( i = 0; i < m_pFeedbackElements->len; i++ ) {
-		GtkTreeIter iter;
+	else
+	{
+		// the list already holds the others
 		gtk_list_store_append( m_clist, &iter );
-		gtk_list_store_set( m_clist, &iter, 0, GetElement( i )->getName(), -1 );
+		gtk_list_store_set( m_clist, &iter, 0, pHandler->getName(), -1 );
 	}
 
 	ShowDlg();
@@ -60,9 +60,13 @@ static bfilter_t   *baseFilters[MAX_BASE_FILTERS];
 static int baseFilterExcludes[MAX_BASE_FILTERS];
 static int numBaseFilters = 0;
 
+// bumped whenever filters are added or deleted, see FilterPrepare
+static int filterListRevision = 0;
+
 // This shall not be called from outside filters.cpp.
 bfilter_t *FilterAddImpl( bfilter_t *pFilter, int type, int bmask, const char *str, int exclude, bool baseFilter ){
 	bfilter_t *pNew = new bfilter_t;
+	filterListRevision++;
 	pNew->next = pFilter;
 	pNew->attribute = type;
 	if ( type == 1 || type == 3 ) {
@@ -122,6 +126,7 @@ bfilter_t *FilterListDelete( bfilter_t *pFilter ){
 	}
 	else
 	{
+		filterListRevision++;
 		memset( baseFilters, 0, sizeof( baseFilters ) ); // Strictly speaking we don't really need this.
 		memset( baseFilterExcludes, 0, sizeof( baseFilterExcludes ) ); // Strictly speaking we don't really need this.
 		numBaseFilters = 0; // We do need this.
@@ -149,6 +154,8 @@ bfilter_t *FilterAddBase( bfilter_t *pFilter ){
 	return pFilter;
 }
 
+static void FilterPrepare();
+
 void FilterUpdateBase(){
 	int i;
 	bfilter_t   *filter;
@@ -164,6 +171,220 @@ void FilterUpdateBase(){
 			filter->active = false;
 		}
 	}
+
+	// PerformFiltering comes through here before it walks the brushes
+	FilterPrepare();
+}
+
+/*
+    Filter masks.
+
+    FilterBrush used to strstr every face's shader name against every active name filter
+    and strcmp the eclass name several times per brush. Instead, the name filters (type 1
+    and 3) each get a bit, and what a given shader name or eclass name matches is worked
+    out once and kept in a hash table keyed by the name. Shaders that show up later are
+    added on first use; the tables are flushed when filters are added or deleted.
+    The active masks below are rebuilt once per PerformFiltering (through FilterUpdateBase),
+    which every filter toggle goes through, so FilterBrush itself only tests masks and
+    every face costs a table lookup and a mask test.
+    The flag filters (types 2, 4, 5, 6) are folded into one OR'ed mask each.
+ */
+
+#define MAX_FILTER_BITS 64
+
+typedef struct filterEclassInfo_s
+{
+	guint64 nameMask;   // type 3 filters matching the eclass name
+	bool bWorld;        // worldspawn
+	bool bFuncGroup;    // func_group, treated as world by EXCLUDE_WORLD and EXCLUDE_ENT
+	bool bBrushModel;   // worldspawn, func* or trigger*: faces are filtered by shader
+} filterEclassInfo_t;
+
+static struct
+{
+	int revision;                                   // filterListRevision the tables are for
+	GHashTable *shaderMasks;                        // shader name -> guint64 of type 1 filters
+	GHashTable *eclassInfo;                         // eclass name -> filterEclassInfo_t
+
+	bfilter_t *nameFilters[MAX_FILTER_BITS];        // type 1 filter for each bit
+	int numNameFilters;
+	bfilter_t *entityFilters[MAX_FILTER_BITS];      // type 3 filter for each bit
+	int numEntityFilters;
+	bool bOverflow;                                 // more name filters than bits, the rest are tested directly
+
+	// rebuilt by FilterPrepare
+	guint64 activeNames, activeEntities;
+	int shaderFlags, showFlags, surfaceFlags, contentFlags;
+	bool bNoContents;                               // an active type 7 filter
+} filterMasks = { -1, NULL, NULL };
+
+static void FilterPrepare(){
+	bfilter_t *filter;
+	int nameBit, entityBit;
+
+	if ( filterMasks.revision != filterListRevision ) {
+		if ( filterMasks.shaderMasks ) {
+			g_hash_table_destroy( filterMasks.shaderMasks );
+			g_hash_table_destroy( filterMasks.eclassInfo );
+		}
+		filterMasks.shaderMasks = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+		filterMasks.eclassInfo = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+
+		filterMasks.numNameFilters = filterMasks.numEntityFilters = 0;
+		filterMasks.bOverflow = false;
+		for ( filter = g_qeglobals.d_savedinfo.filters; filter != NULL; filter = filter->next )
+		{
+			if ( filter->attribute == 1 ) {
+				if ( filterMasks.numNameFilters < MAX_FILTER_BITS ) {
+					filterMasks.nameFilters[filterMasks.numNameFilters++] = filter;
+				}
+				else{
+					filterMasks.bOverflow = true;
+				}
+			}
+			else if ( filter->attribute == 3 ) {
+				if ( filterMasks.numEntityFilters < MAX_FILTER_BITS ) {
+					filterMasks.entityFilters[filterMasks.numEntityFilters++] = filter;
+				}
+				else{
+					filterMasks.bOverflow = true;
+				}
+			}
+		}
+		filterMasks.revision = filterListRevision;
+	}
+
+	// the active flags can change without the list changing (menu toggles, plugins)
+	filterMasks.activeNames = filterMasks.activeEntities = 0;
+	filterMasks.shaderFlags = filterMasks.showFlags = filterMasks.surfaceFlags = filterMasks.contentFlags = 0;
+	filterMasks.bNoContents = false;
+	nameBit = entityBit = 0;
+	for ( filter = g_qeglobals.d_savedinfo.filters; filter != NULL; filter = filter->next )
+	{
+		switch ( filter->attribute )
+		{
+		case 1:
+			if ( filter->active && nameBit < MAX_FILTER_BITS ) {
+				filterMasks.activeNames |= (guint64)1 << nameBit;
+			}
+			nameBit++;
+			break;
+		case 3:
+			if ( filter->active && entityBit < MAX_FILTER_BITS ) {
+				filterMasks.activeEntities |= (guint64)1 << entityBit;
+			}
+			entityBit++;
+			break;
+		case 2:
+			if ( filter->active ) {
+				filterMasks.shaderFlags |= filter->mask;
+			}
+			break;
+		case 4:
+			if ( filter->active ) {
+				filterMasks.showFlags |= filter->mask;
+			}
+			break;
+		case 5:
+			if ( filter->active ) {
+				filterMasks.surfaceFlags |= filter->mask;
+			}
+			break;
+		case 6:
+			if ( filter->active ) {
+				filterMasks.contentFlags |= filter->mask;
+			}
+			break;
+		case 7:
+			if ( filter->active ) {
+				filterMasks.bNoContents = true;
+			}
+			break;
+		}
+	}
+}
+
+// type 1 filters matching the shader name
+static guint64 FilterShaderMask( const char *name ){
+	guint64 *mask = (guint64 *)g_hash_table_lookup( filterMasks.shaderMasks, name );
+
+	if ( !mask ) {
+		mask = g_new0( guint64, 1 );
+		for ( int i = 0; i < filterMasks.numNameFilters; i++ )
+			if ( strstr( name, filterMasks.nameFilters[i]->string ) ) {
+				*mask |= (guint64)1 << i;
+			}
+		g_hash_table_insert( filterMasks.shaderMasks, g_strdup( name ), mask );
+	}
+	return *mask;
+}
+
+static const filterEclassInfo_t *FilterEclassInfo( const char *name ){
+	filterEclassInfo_t *info = (filterEclassInfo_t *)g_hash_table_lookup( filterMasks.eclassInfo, name );
+
+	if ( !info ) {
+		info = g_new0( filterEclassInfo_t, 1 );
+		info->bWorld = !strcmp( name, "worldspawn" );
+		info->bFuncGroup = !strcmp( name, "func_group" );
+		info->bBrushModel = info->bWorld || !strncmp( name, "func", 4 ) || !strncmp( name, "trigger", 7 );
+		for ( int i = 0; i < filterMasks.numEntityFilters; i++ )
+			if ( strstr( name, filterMasks.entityFilters[i]->string ) ) {
+				info->nameMask |= (guint64)1 << i;
+			}
+		g_hash_table_insert( filterMasks.eclassInfo, g_strdup( name ), info );
+	}
+	return info;
+}
+
+// name filters past MAX_FILTER_BITS, tested the old way
+static bool FilterOverflowName( const char *name, int attribute ){
+	int bit = 0;
+
+	for ( bfilter_t *filter = g_qeglobals.d_savedinfo.filters; filter != NULL; filter = filter->next )
+	{
+		if ( filter->attribute != attribute ) {
+			continue;
+		}
+		if ( bit++ < MAX_FILTER_BITS ) {
+			continue;
+		}
+		if ( filter->active && strstr( name, filter->string ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool FilterFace( face_t *f ){
+	const char *name = f->pShader->getName();
+
+	// exclude by attribute 1 brush->face->pShader->getName()
+	if ( FilterShaderMask( name ) & filterMasks.activeNames ) {
+		return true;
+	}
+	if ( filterMasks.bOverflow && FilterOverflowName( name, 1 ) ) {
+		return true;
+	}
+	// exclude by attribute 2 brush->face->pShader->getFlags()
+	if ( f->pShader->getFlags() & filterMasks.shaderFlags ) {
+		return true;
+	}
+	// quake2 - 5 == surface flags, 6 == content flags
+	if ( f->texdef.flags && f->texdef.flags & filterMasks.surfaceFlags ) {
+		return true;
+	}
+	if ( f->texdef.contents && f->texdef.contents & filterMasks.contentFlags ) {
+		return true;
+	}
+	if ( filterMasks.bNoContents && f->texdef.contents ) {
+		for ( bfilter_t *filter = g_qeglobals.d_savedinfo.filters; filter != NULL; filter = filter->next )
+		{
+			if ( filter->active && filter->attribute == 7 && !( f->texdef.contents & filter->mask ) ) {
+				return true;
+			}
+		}
+	}
+	return false;
 }
 
 /*
@@ -173,6 +394,7 @@ void FilterUpdateBase(){
  */
 
 bool FilterBrush( brush_t *pb ){
+	const filterEclassInfo_t *info;
 
 	if ( !pb->owner ) {
 		return FALSE;       // during construction
@@ -182,14 +404,20 @@ bool FilterBrush( brush_t *pb ){
 		return TRUE;
 	}
 
+	// filters added or deleted since the last PerformFiltering
+	if ( filterMasks.revision != filterListRevision ) {
+		FilterPrepare();
+	}
+	info = FilterEclassInfo( pb->owner->eclass->name );
+
 	if ( g_qeglobals.d_savedinfo.exclude & EXCLUDE_WORLD ) {
-		if ( strcmp( pb->owner->eclass->name, "worldspawn" ) == 0 || !strcmp( pb->owner->eclass->name,"func_group" ) ) { // hack, treating func_group as world
+		if ( info->bWorld || info->bFuncGroup ) { // hack, treating func_group as world
 			return TRUE;
 		}
 	}
 
 	if ( g_qeglobals.d_savedinfo.exclude & EXCLUDE_ENT ) {
-		if ( strcmp( pb->owner->eclass->name, "worldspawn" ) != 0 && strcmp( pb->owner->eclass->name,"func_group" ) ) { // hack, treating func_group as world
+		if ( !info->bWorld && !info->bFuncGroup ) { // hack, treating func_group as world
 			return TRUE;
 		}
 	}
@@ -213,54 +441,11 @@ bool FilterBrush( brush_t *pb ){
 	}
 
 	// if brush belongs to world entity or a brushmodel entity and is not a patch
-	if ( ( strcmp( pb->owner->eclass->name, "worldspawn" ) == 0
-		   || !strncmp( pb->owner->eclass->name, "func", 4 )
-		   || !strncmp( pb->owner->eclass->name, "trigger", 7 ) ) && !pb->patchBrush ) {
+	if ( info->bBrushModel && !pb->patchBrush ) {
 		bool filterbrush = false;
 		for ( face_t *f = pb->brush_faces; f != NULL; f = f->next )
 		{
-			filterbrush = false;
-			for ( bfilter_t *filters = g_qeglobals.d_savedinfo.filters;
-				  filters != NULL;
-				  filters = filters->next )
-			{
-				if ( !filters->active ) {
-					continue;
-				}
-				// exclude by attribute 1 brush->face->pShader->getName()
-				if ( filters->attribute == 1 ) {
-					if ( strstr( f->pShader->getName(),filters->string ) ) {
-						filterbrush = true;
-						break;
-					}
-				}
-				// exclude by attribute 2 brush->face->pShader->getFlags()
-				else if ( filters->attribute == 2 ) {
-					if ( f->pShader->getFlags() & filters->mask ) {
-						filterbrush = true;
-						break;
-					}
-					// quake2 - 5 == surface flags, 6 == content flags
-				}
-				else if ( filters->attribute == 5 ) {
-					if ( f->texdef.flags && f->texdef.flags & filters->mask ) {
-						filterbrush = true;
-						break;
-					}
-				}
-				else if ( filters->attribute == 6 ) {
-					if ( f->texdef.contents && f->texdef.contents & filters->mask ) {
-						filterbrush = true;
-						break;
-					}
-				}
-				else if ( filters->attribute == 7 ) {
-					if ( f->texdef.contents && !( f->texdef.contents & filters->mask ) ) {
-						filterbrush = true;
-						break;
-					}
-				}
-			}
+			filterbrush = FilterFace( f );
 			if ( !filterbrush ) {
 				break;
 			}
@@ -272,61 +457,28 @@ bool FilterBrush( brush_t *pb ){
 
 	// if brush is a patch
 	if ( pb->patchBrush ) {
-		bool drawpatch = true;
-		for ( bfilter_t *filters = g_qeglobals.d_savedinfo.filters;
-			  filters != NULL;
-			  filters = filters->next )
-		{
-			// exclude by attribute 1 (for patch) brush->pPatch->pShader->getName()
-			if ( filters->active
-				 && filters->attribute == 1 ) {
-				if ( strstr( pb->pPatch->pShader->getName(),filters->string ) ) {
-					drawpatch = false;
-					break;
-				}
-			}
-
-			// exclude by attribute 2 (for patch) brush->pPatch->pShader->getFlags()
-			if ( filters->active
-				 && filters->attribute == 2 ) {
-				if ( pb->pPatch->pShader->getFlags() & filters->mask ) {
-					drawpatch = false;
-					break;
-				}
-			}
-		}
-		if ( !drawpatch ) { // if a shader is found that should be excluded
+		const char *name = pb->pPatch->pShader->getName();
+		// exclude by attribute 1 (for patch) brush->pPatch->pShader->getName()
+		if ( ( FilterShaderMask( name ) & filterMasks.activeNames )
+			 || ( filterMasks.bOverflow && FilterOverflowName( name, 1 ) ) ) {
 			return TRUE; // exclude this patch
 		}
+		// exclude by attribute 2 (for patch) brush->pPatch->pShader->getFlags()
+		if ( pb->pPatch->pShader->getFlags() & filterMasks.shaderFlags ) {
+			return TRUE;
+		}
 	}
 
-	if ( strcmp( pb->owner->eclass->name, "worldspawn" ) != 0 ) { // if brush does not belong to world entity
-		bool drawentity = true;
-		for ( bfilter_t *filters = g_qeglobals.d_savedinfo.filters;
-			  filters != NULL;
-			  filters = filters->next )
-		{
-			// exclude by attribute 3 brush->owner->eclass->name
-			if ( filters->active
-				 && filters->attribute == 3 ) {
-				if ( strstr( pb->owner->eclass->name,filters->string ) ) {
-					drawentity = false;
-					break;
-				}
-			}
-
-			// exclude by attribute 4 brush->owner->eclass->nShowFlags
-			else if ( filters->active
-					  && filters->attribute == 4 ) {
-				if ( pb->owner->eclass->nShowFlags & filters->mask ) {
-					drawentity = false;
-					break;
-				}
-			}
-		}
-		if ( !drawentity ) { // if an eclass property is found that should be excluded
+	if ( !info->bWorld ) { // if brush does not belong to world entity
+		// exclude by attribute 3 brush->owner->eclass->name
+		if ( ( info->nameMask & filterMasks.activeEntities )
+			 || ( filterMasks.bOverflow && FilterOverflowName( pb->owner->eclass->name, 3 ) ) ) {
 			return TRUE; // exclude this brush
 		}
+		// exclude by attribute 4 brush->owner->eclass->nShowFlags
+		if ( pb->owner->eclass->nShowFlags & filterMasks.showFlags ) {
+			return TRUE;
+		}
 	}
 	return FALSE;
 }
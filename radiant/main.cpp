@@ -493,6 +493,13 @@ int main( int argc, char* argv[] ) {
 	textdomain( GETTEXT_PACKAGE );
 //  gtk_disable_setlocale();
 
+#if !GLIB_CHECK_VERSION( 2, 32, 0 )
+	// Brush_BuildList spawns worker threads
+	if ( !g_thread_supported() ) {
+		g_thread_init( NULL );
+	}
+#endif
+
 	gtk_init( &argc, &argv );
 	gtk_gl_init( &argc, &argv );
 	gdk_gl_init( &argc, &argv );
@@ -3279,6 +3279,9 @@ void MainFrame::OnDestroy(){
 		gtk_timeout_remove( m_nTimer );
 	}
 
+	// let a background autosave finish writing
+	Map_WaitForBackgroundSave();
+
 	if ( !g_qeglobals.disable_ini ) {
 		Sys_Printf( "Start writing prefs\n" );
 		Sys_Printf( "MRU_Save... " );
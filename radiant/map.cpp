@@ -120,11 +120,16 @@ void Map_BuildBrushData( void ){
 
 	Sys_BeginWait(); // this could take a while
 
+	GPtrArray *build_brushes = g_ptr_array_new();
+	for ( b = active_brushes.next ; b != NULL && b != &active_brushes ; b = b->next )
+		g_ptr_array_add( build_brushes, (gpointer)b );
+	Brush_BuildList( (brush_t **)build_brushes->pdata, build_brushes->len, true, false );
+	g_ptr_array_free( build_brushes, TRUE );
+
 	int n = 0;
 	for ( b = active_brushes.next ; b != NULL && b != &active_brushes ; b = next )
 	{
 		next = b->next;
-		Brush_Build( b, true, false, false );
 		if ( !b->brush_faces || ( g_PrefsDlg.m_bCleanTiny && CheckForTinyBrush( b, n++, g_PrefsDlg.m_fTinySize ) ) ) {
 			Brush_Free( b );
 			Sys_Printf( "Removed degenerate brush\n" );
@@ -167,6 +172,7 @@ void Map_Free( void ){
 	if ( !active_brushes.next ) {
 		// first map
 		active_brushes.prev = active_brushes.next = &active_brushes;
+		XY_InvalidateIndex();
 		selected_brushes.prev = selected_brushes.next = &selected_brushes;
 		filtered_brushes.prev = filtered_brushes.next = &filtered_brushes;
 		entities.prev = entities.next = &entities;
@@ -317,6 +323,7 @@ void Map_ImportEntities( CPtrArray *ents, bool bAddSelected = false ){
 	}
 
 	// process the entities into the world geometry
+	GPtrArray *build_brushes = g_ptr_array_new();
 	num_ents = ents->GetSize();
 	for ( i = 0; i < num_ents; i++ )
 	{
@@ -342,7 +349,7 @@ void Map_ImportEntities( CPtrArray *ents, bool bAddSelected = false ){
 		e->eclass = Eclass_ForName( ValueForKey( e, "classname" ),
 									( e->brushes.onext != &e->brushes ) );
 
-		// go through all parsed brushes and build stuff
+		// go through all parsed brushes and bind the shaders
 		for ( b = e->brushes.onext; b != &e->brushes; b = b->onext )
 		{
 			for ( f = b->brush_faces; f != NULL; f = f->next )
@@ -350,11 +357,18 @@ void Map_ImportEntities( CPtrArray *ents, bool bAddSelected = false ){
 				f->pShader = QERApp_Shader_ForName( f->texdef.GetName() );
 				f->d_texture = f->pShader->getTexture();
 			}
-
-			// when brushes are in final state, build the planes and windings
-			// NOTE: also converts BP brushes if g_qeglobals.bNeedConvert is true
-			Brush_Build( b );
+			g_ptr_array_add( build_brushes, (gpointer)b );
 		}
+	}
+
+	// when brushes are in final state, build the planes and windings of all of them at once
+	// NOTE: also converts BP brushes if g_qeglobals.bNeedConvert is true
+	Brush_BuildList( (brush_t **)build_brushes->pdata, build_brushes->len );
+	g_ptr_array_free( build_brushes, TRUE );
+
+	for ( i = 0; i < num_ents; i++ )
+	{
+		e = (entity_t*)ents->GetAt( i );
 
 //#define TERRAIN_HACK
 #undef TERRAIN_HACK
@@ -769,6 +783,10 @@ const char* filename_get_extension( const char* filename ){
 void Map_SaveFile( const char *filename, qboolean use_region ){
 	clock_t start, finish;
 	double elapsed_time;
+
+	// don't race a background autosave to the same file
+	Map_WaitForBackgroundSave();
+
 	start = clock();
 	Sys_Printf( "Saving map to %s\n",filename );
 
@@ -820,6 +838,129 @@ void Map_SaveFile( const char *filename, qboolean use_region ){
 	}
 }
 
+/*
+   ===========
+   Map_SaveFileInBackground
+
+   autosaves and snapshots: the map is exported to memory on the main thread (an immutable copy
+   of the brushes and entities as text), the .bak rotation and the disk write run on a worker thread
+   so editing can go on meanwhile. the result is reported from an idle callback on the main thread
+   returns false if the previous background save is still pending
+   ===========
+ */
+typedef struct mapSaveJob_s
+{
+	char *filename;
+	MemStream *data;
+	GThread *thread;
+	bool bJoined;
+	bool bResult;
+	GTimer *timer;
+} mapSaveJob_t;
+
+static mapSaveJob_t *g_pMapSaveJob = NULL; // pending background save, until its result is reported
+
+static gpointer Map_SaveFileWorker( gpointer data );
+static gboolean Map_SaveFileDone( gpointer data );
+
+bool Map_SaveFileInBackground( const char *filename ){
+	mapSaveJob_t *job;
+
+	if ( g_pMapSaveJob ) {
+		Sys_Printf( "Previous save of %s still in progress, skipping\n", g_pMapSaveJob->filename );
+		return false;
+	}
+
+	Sys_Printf( "Saving map to %s in the background\n", filename );
+
+	Pointfile_Clear();
+
+	job = new mapSaveJob_t;
+	job->filename = g_strdup( filename );
+	job->data = new MemStream();
+	job->bJoined = false;
+	job->bResult = false;
+	job->timer = g_timer_new();
+
+	// snapshot the map
+	Map_Export( job->data, filename_get_extension( filename ), false );
+
+	g_pMapSaveJob = job;
+#if GLIB_CHECK_VERSION( 2, 32, 0 )
+	job->thread = g_thread_try_new( "map save", Map_SaveFileWorker, job, NULL );
+#else
+	job->thread = g_thread_create( Map_SaveFileWorker, job, TRUE, NULL );
+#endif
+	if ( !job->thread ) {
+		// no thread, write it right here
+		job->bJoined = true;
+		Map_SaveFileWorker( job );
+	}
+
+	return true;
+}
+
+// runs on the worker thread, must not touch the UI or the map
+static gpointer Map_SaveFileWorker( gpointer data ){
+	mapSaveJob_t *job = (mapSaveJob_t *)data;
+	char backup[1024];
+	FILE *f;
+
+	// rename current to .bak
+	strcpy( backup, job->filename );
+	StripExtension( backup );
+	strcat( backup, ".bak" );
+	unlink( backup );
+	rename( job->filename, backup );
+
+	f = fopen( job->filename, "w" );
+	if ( f ) {
+		job->bResult = ( fwrite( job->data->GetBuffer(), 1, job->data->GetLength(), f ) == job->data->GetLength() );
+		job->bResult = ( fclose( f ) == 0 ) && job->bResult;
+	}
+
+	g_idle_add( Map_SaveFileDone, job );
+	return NULL;
+}
+
+static gboolean Map_SaveFileDone( gpointer data ){
+	mapSaveJob_t *job = (mapSaveJob_t *)data;
+
+	if ( !job->bJoined ) {
+		g_thread_join( job->thread );
+	}
+
+	if ( job->bResult ) {
+		Sys_Printf( "Saved %s in %-.2f second(s).\n", job->filename, g_timer_elapsed( job->timer, NULL ) );
+		Sys_Status( "Autosaving...Saved.", 0 );
+	}
+	else
+	{
+		Sys_FPrintf( SYS_ERR, "ERROR: couldn't write %s\n", job->filename );
+		Sys_Status( "Autosave failed.", 0 );
+	}
+
+	if ( g_pMapSaveJob == job ) {
+		g_pMapSaveJob = NULL;
+	}
+	g_timer_destroy( job->timer );
+	delete job->data;
+	g_free( job->filename );
+	delete job;
+
+	return FALSE;
+}
+
+/*!
+   blocks until the pending background save, if any, is on disk
+ */
+void Map_WaitForBackgroundSave(){
+	if ( g_pMapSaveJob && !g_pMapSaveJob->bJoined ) {
+		g_thread_join( g_pMapSaveJob->thread );
+		g_pMapSaveJob->bJoined = true;
+	}
+}
+
 /*
    ===========
    Map_New
@@ -1061,6 +1202,7 @@ void Map_RegionSelectedBrushes( void ){
 	active_brushes.prev = selected_brushes.prev;
 	active_brushes.next->prev = &active_brushes;
 	active_brushes.prev->next = &active_brushes;
+	XY_InvalidateIndex();
 
 	// deselect patches
 	for ( brush_t *b = active_brushes.next; b != &active_brushes; b = b->next )
@@ -47,6 +47,8 @@ void Map_Init();
 
 void    Map_LoadFile( const char *filename );
 void    Map_SaveFile( const char *filename, qboolean use_region );
+bool    Map_SaveFileInBackground( const char *filename );
+void    Map_WaitForBackgroundSave();
 
 void    Map_New( void );
 void  Map_Free( void );
@@ -1612,6 +1612,7 @@ void CPlugInManager::CommitEntityHandleToMap( void* vpEntity ){
 				active_brushes.next->prev = b;
 				b->prev = &active_brushes;
 				active_brushes.next = b;
+				XY_InvalidateIndex();
 			}
 
 			// handle worldspawn entities
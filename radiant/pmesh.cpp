@@ -27,8 +27,6 @@
 #include "stdafx.h"
 #include "gtkmisc.h"
 
-#include "gtkr_list.h"
-
 // externs
 extern void MemFile_fprintf( MemStream* pMemFile, const char* pText, ... );
 extern face_t *Face_Alloc( void );
@@ -2814,6 +2812,23 @@ void Patch_ClearLODFlags( patchMesh_t *p ){
 void Patch_LODMatchAll(){
 	brush_t *pb, *brushlist;
 	int i;
+	static int subdivisions = -1;
+
+	// a new subdivision setting invalidates every LOD tree and cached tessellation
+	if ( subdivisions != g_PrefsDlg.m_nSubdivisions ) {
+		subdivisions = g_PrefsDlg.m_nSubdivisions;
+		brushlist = &active_brushes;
+		for ( i = 0; i < 2; i++ )
+		{
+			for ( pb = brushlist->next; pb && ( pb != brushlist ); pb = pb->next )
+			{
+				if ( pb->patchBrush ) {
+					pb->pPatch->bDirty = true;
+				}
+			}
+			brushlist = &selected_brushes;
+		}
+	}
 
 	// create LOD tree roots and LOD tree lists for all patches that are dirty
 
@@ -2899,19 +2914,67 @@ void Patch_TransformLODTexture( patchMesh_t *p, float fx, float fy, transformtyp
 			BTree_TransformTexture( p->colLOD[( ( ( row - 1 ) / 2 ) * p->width ) + col], fx, fy, xform );
 }
 
-void Patch_AddBTreeToDrawListInOrder( list<drawVert_t> *drawList, BTNode_t *pBT ){
+// flat patch tessellation, built from the LOD trees and cached in patchMesh_t::drawLists
+// verts holds every tessellated row back to back, rowStart[i] is the first vertex of row i
+// strip i (rows i and i+1) is drawn as a quad strip from indexes[stripStart[i]] to indexes[stripStart[i + 1]]
+typedef struct
+{
+	int numRows;
+	int numVerts;
+	int numIndexes;
+	int *rowStart;
+	int *stripStart;
+	unsigned int *indexes;
+	drawVert_t *verts;
+} patchTess_t;
+
+// rows are gathered in scratch arrays that are kept around between builds
+typedef struct
+{
+	int numVerts;
+	int maxVerts;
+	drawVert_t *verts;
+} patchTessRow_t;
+
+static patchTessRow_t *s_tessRows = NULL;
+static int s_numTessRows = 0;
+static int s_maxTessRows = 0;
+
+static patchTessRow_t *Patch_TessAddRow(){
+	patchTessRow_t *row;
+
+	if ( s_numTessRows == s_maxTessRows ) {
+		s_maxTessRows = s_maxTessRows ? s_maxTessRows * 2 : 64;
+		s_tessRows = (patchTessRow_t *)realloc( s_tessRows, s_maxTessRows * sizeof( patchTessRow_t ) );
+		memset( s_tessRows + s_numTessRows, 0, ( s_maxTessRows - s_numTessRows ) * sizeof( patchTessRow_t ) );
+	}
+
+	row = &s_tessRows[s_numTessRows++];
+	row->numVerts = 0;
+	return row;
+}
+
+static void Patch_TessAddVert( patchTessRow_t *row, const drawVert_t &vert ){
+	if ( row->numVerts == row->maxVerts ) {
+		row->maxVerts = row->maxVerts ? row->maxVerts * 2 : 64;
+		row->verts = (drawVert_t *)realloc( row->verts, row->maxVerts * sizeof( drawVert_t ) );
+	}
+	row->verts[row->numVerts++] = vert;
+}
+
+void Patch_AddBTreeToDrawListInOrder( patchTessRow_t *row, BTNode_t *pBT ){
 	if ( pBT != NULL ) { //traverse InOrder
-		Patch_AddBTreeToDrawListInOrder( drawList, pBT->left );
+		Patch_AddBTreeToDrawListInOrder( row, pBT->left );
 		if ( pBT->left != NULL && pBT->right != NULL ) {
-			drawList->push_back( pBT->vMid );
+			Patch_TessAddVert( row, pBT->vMid );
 		}
-		Patch_AddBTreeToDrawListInOrder( drawList, pBT->right );
+		Patch_AddBTreeToDrawListInOrder( row, pBT->right );
 	}
 }
 
-void Patch_InterpolateListFromRowBT( list<drawVert_t> *drawList, BTNode_t *rowBT, BTNode_t *rowBTLeft, drawVert_t *vCurve[], float u, float n, float v ){
+void Patch_InterpolateListFromRowBT( patchTessRow_t *row, BTNode_t *rowBT, BTNode_t *rowBTLeft, drawVert_t *vCurve[], float u, float n, float v ){
 	if ( rowBT != NULL ) {
-		Patch_InterpolateListFromRowBT( drawList, rowBT->left, rowBTLeft->left, vCurve, u - n, n * 0.5f, v );
+		Patch_InterpolateListFromRowBT( row, rowBT->left, rowBTLeft->left, vCurve, u - n, n * 0.5f, v );
 		if ( rowBT->left != NULL && rowBT->right != NULL ) {
 			vec3_t v1, v2;
 			drawVert_t newVert, vTemp1, vTemp2;
@@ -2927,119 +2990,149 @@ void Patch_InterpolateListFromRowBT( list<drawVert_t> *drawList, BTNode_t *rowBT
 			VectorNormalize( newVert.normal, newVert.normal );
 			//if (!g_PrefsDlg.m_bGLLighting)
 			//	ShadeVertex(newVert);
-			drawList->push_back( newVert );
+			Patch_TessAddVert( row, newVert );
 		}
-		Patch_InterpolateListFromRowBT( drawList, rowBT->right, rowBTLeft->right, vCurve, u + n, n * 0.5f, v );
+		Patch_InterpolateListFromRowBT( row, rowBT->right, rowBTLeft->right, vCurve, u + n, n * 0.5f, v );
 	}
 }
 
-void Patch_TraverseColBTInOrder( list<list<drawVert_t>*>::iterator& iter, BTNode_t *colBTLeft, BTNode_t *colBT, BTNode_t *colBTRight, BTNode_t *rowBT, BTNode_t *rowBTLeft, float v, float n ){
+void Patch_TraverseColBTInOrder( int &row, BTNode_t *colBTLeft, BTNode_t *colBT, BTNode_t *colBTRight, BTNode_t *rowBT, BTNode_t *rowBTLeft, float v, float n ){
 	if ( colBT != NULL ) {
 		//traverse subtree In Order
-		Patch_TraverseColBTInOrder( iter, colBTLeft->left, colBT->left, colBTRight->left, rowBT, rowBTLeft, v - n, n * 0.5f );
+		Patch_TraverseColBTInOrder( row, colBTLeft->left, colBT->left, colBTRight->left, rowBT, rowBTLeft, v - n, n * 0.5f );
 		if ( colBT->left != NULL && colBT->right != NULL ) {
 			drawVert_t *vCurve[3];
 			vCurve[0] = &colBTLeft->vMid;
 			vCurve[1] = &colBT->vMid;
 			vCurve[2] = &colBTRight->vMid;
-			Patch_InterpolateListFromRowBT( ( *iter ), rowBT, rowBTLeft, vCurve, 0.5f, 0.25f, v );
+			Patch_InterpolateListFromRowBT( &s_tessRows[row], rowBT, rowBTLeft, vCurve, 0.5f, 0.25f, v );
 
-			( *iter )->push_back( colBTRight->vMid );
-			iter++;
+			Patch_TessAddVert( &s_tessRows[row], colBTRight->vMid );
+			row++;
 		}
-		Patch_TraverseColBTInOrder( iter, colBTLeft->right, colBT->right, colBTRight->right, rowBT, rowBTLeft, v + n, n * 0.5f );
+		Patch_TraverseColBTInOrder( row, colBTLeft->right, colBT->right, colBTRight->right, rowBT, rowBTLeft, v + n, n * 0.5f );
 	}
 }
 
 
-void Patch_StartDrawLists( list<list<drawVert_t>*> *drawLists, BTNode_t *colBT ){
+void Patch_StartDrawLists( BTNode_t *colBT ){
 	if ( colBT != NULL ) {
 		//traverse subtree In Order
-		Patch_StartDrawLists( drawLists, colBT->left );
+		Patch_StartDrawLists( colBT->left );
 		if ( colBT->left != NULL && colBT->right != NULL ) {
-			list<drawVert_t> *newList = new list<drawVert_t>;
-			drawLists->push_back( newList ); // add empty list to back
-			drawLists->back()->push_back( colBT->vMid );
+			Patch_TessAddVert( Patch_TessAddRow(), colBT->vMid ); // start a new row
 		}
-		Patch_StartDrawLists( drawLists, colBT->right );
+		Patch_StartDrawLists( colBT->right );
 	}
 }
 
-typedef list<drawVert_t> drawList_t;
-typedef list<list<drawVert_t>*> drawLists_t;
-
 void Patch_CreateDrawLists( patchMesh_t *patch ){
-	int col, row, colpos, rowpos;
-
-	drawLists_t *drawLists = new drawLists_t;
-
-	drawLists_t::iterator iter1, iter2;
+	int col, row, colpos, rowpos, tessRow, rowTess;
+	int i, j, count, numVerts, numIndexes;
+	patchTess_t *tess;
+	unsigned int *index;
 
+	// gather the rows
+	s_numTessRows = 0;
 	for ( row = 0; row < patch->height; row += 2 )
 	{
 		colpos = ( row / 2 ) * patch->width;
-		drawList_t *newList = new drawList_t;
-		drawLists->push_back( newList ); // add a new empty list to back
-		drawLists->back()->push_back( patch->ctrl[0][row] ); // fill list at back
+		Patch_TessAddVert( Patch_TessAddRow(), patch->ctrl[0][row] );
 
 		if ( row + 1 == patch->height ) {
 			continue;
 		}
-		Patch_StartDrawLists( drawLists, patch->colLOD[colpos] );
+		Patch_StartDrawLists( patch->colLOD[colpos] );
 	}
 
-	iter1 = drawLists->begin();
+	tessRow = 0;
 	for ( row = 0; row < patch->height; row += 2 )
 	{
-		iter2 = iter1;
+		rowTess = tessRow;
 		for ( col = 0; col + 1 < patch->width; col += 2 )
 		{
-			iter1 = iter2;
+			tessRow = rowTess;
 			colpos = ( ( row / 2 ) * patch->width ) + col;
 			rowpos = ( ( col / 2 ) * patch->height ) + row;
 
-			Patch_AddBTreeToDrawListInOrder( ( *iter1 ), patch->rowLOD[rowpos] );
-			( *iter1 )->push_back( patch->ctrl[col + 2][row] );
+			Patch_AddBTreeToDrawListInOrder( &s_tessRows[tessRow], patch->rowLOD[rowpos] );
+			Patch_TessAddVert( &s_tessRows[tessRow], patch->ctrl[col + 2][row] );
 
 			if ( row + 1 == patch->height ) {
 				continue;
 			}
 
-			iter1++;
+			tessRow++;
 
-			Patch_TraverseColBTInOrder( iter1, patch->colLOD[colpos], patch->colLOD[colpos + 1], patch->colLOD[colpos + 2], patch->rowLOD[rowpos + 1], patch->rowLOD[rowpos], 0.5, 0.25 );
+			Patch_TraverseColBTInOrder( tessRow, patch->colLOD[colpos], patch->colLOD[colpos + 1], patch->colLOD[colpos + 2], patch->rowLOD[rowpos + 1], patch->rowLOD[rowpos], 0.5, 0.25 );
 		}
 	}
 
-	patch->drawLists = drawLists;
-}
+	// size the flat copy
+	numVerts = 0;
+	numIndexes = 0;
+	for ( i = 0; i < s_numTessRows; i++ )
+	{
+		numVerts += s_tessRows[i].numVerts;
+		if ( i + 1 < s_numTessRows ) {
+			numIndexes += 2 * MIN( s_tessRows[i].numVerts, s_tessRows[i + 1].numVerts );
+		}
+	}
 
+	// one allocation holds the header, the vertices and the strip indexes
+	tess = (patchTess_t *)malloc( sizeof( patchTess_t ) + numVerts * sizeof( drawVert_t )
+								  + ( s_numTessRows + 1 ) * 2 * sizeof( int ) + numIndexes * sizeof( unsigned int ) );
+	tess->numRows = s_numTessRows;
+	tess->numVerts = numVerts;
+	tess->numIndexes = numIndexes;
+	tess->verts = (drawVert_t *)( tess + 1 );
+	tess->rowStart = (int *)( tess->verts + numVerts );
+	tess->stripStart = tess->rowStart + s_numTessRows + 1;
+	tess->indexes = (unsigned int *)( tess->stripStart + s_numTessRows + 1 );
 
-void Patch_DeleteDrawLists( patchMesh_t *patch ){
-	drawLists_t *drawLists;
-	drawLists_t::iterator iter;
+	numVerts = 0;
+	for ( i = 0; i < s_numTessRows; i++ )
+	{
+		tess->rowStart[i] = numVerts;
+		memcpy( tess->verts + numVerts, s_tessRows[i].verts, s_tessRows[i].numVerts * sizeof( drawVert_t ) );
+		numVerts += s_tessRows[i].numVerts;
+	}
+	tess->rowStart[s_numTessRows] = numVerts;
 
-	if ( patch->drawLists == NULL ) {
-		return;
+	// traverse two rows at once to build each strip
+	index = tess->indexes;
+	for ( i = 0; i < s_numTessRows; i++ )
+	{
+		tess->stripStart[i] = index - tess->indexes;
+		if ( i + 1 == s_numTessRows ) {
+			continue;
+		}
+		count = MIN( s_tessRows[i].numVerts, s_tessRows[i + 1].numVerts );
+		for ( j = 0; j < count; j++ )
+		{
+			*index++ = tess->rowStart[i] + j;
+			*index++ = tess->rowStart[i + 1] + j;
+		}
 	}
+	tess->stripStart[s_numTessRows] = numIndexes;
 
-	drawLists = (drawLists_t *)patch->drawLists;
+	patch->drawLists = tess;
+}
 
-	for ( iter = drawLists->begin(); iter != drawLists->end(); iter++ )
-	{
-		delete ( *iter );
+
+void Patch_DeleteDrawLists( patchMesh_t *patch ){
+	if ( patch->drawLists == NULL ) {
+		return;
 	}
 
-	delete drawLists;
+	free( patch->drawLists );
 	patch->drawLists = NULL;
 }
 
 
 void Patch_DrawLODPatchMesh( patchMesh_t *patch ){
-	drawLists_t *drawLists;
-
-	drawLists_t::iterator iterLists, iterListsNext;
-	drawList_t::iterator iterList, iterListNext;
+	patchTess_t *tess;
+	int i;
 
 	//int nGLState = g_pParentWnd->GetCamera()->Camera()->draw_glstate;
 
@@ -3047,57 +3140,29 @@ void Patch_DrawLODPatchMesh( patchMesh_t *patch ){
 		return;
 	}
 
-	drawLists = (drawLists_t *)patch->drawLists;
+	tess = (patchTess_t *)patch->drawLists;
+	if ( tess->numIndexes == 0 ) {
+		return;
+	}
+
+	qglPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+	qglEnableClientState( GL_VERTEX_ARRAY );
+	qglEnableClientState( GL_NORMAL_ARRAY );
+	qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	qglDisableClientState( GL_COLOR_ARRAY );
+	qglVertexPointer( 3, GL_FLOAT, sizeof( drawVert_t ), tess->verts[0].xyz );
+	qglNormalPointer( GL_FLOAT, sizeof( drawVert_t ), tess->verts[0].normal );
+	qglTexCoordPointer( 2, GL_FLOAT, sizeof( drawVert_t ), tess->verts[0].st );
 
-	iterListsNext = drawLists->begin();
-	iterListsNext++;
-	for ( iterLists = drawLists->begin(); iterLists != drawLists->end() && iterListsNext != drawLists->end(); iterLists++, iterListsNext++ )
+	for ( i = 0; i + 1 < tess->numRows; i++ )
 	{
-		// traverse two drawlists at once to draw a strip
 		//if (nGLState & DRAW_GL_LINE)
-		qglBegin( GL_QUAD_STRIP );
+		qglDrawElements( GL_QUAD_STRIP, tess->stripStart[i + 1] - tess->stripStart[i], GL_UNSIGNED_INT, tess->indexes + tess->stripStart[i] );
 		//else
-		//  qglBegin(GL_TRIANGLE_STRIP);
-		for ( iterList = ( *iterLists )->begin(), iterListNext = ( *iterListsNext )->begin(); iterList != ( *iterLists )->end() && iterListNext != ( *iterListsNext )->end(); iterList++, iterListNext++ )
-		{
-			//if (g_PrefsDlg.m_bGLLighting)
-			qglNormal3fv( ( *iterList ).normal );
-			//else if (bShade && !g_PrefsDlg.m_bDisplayLists)
-			//	qglColor3f((*iterList).lightmap[0], (*iterList).lightmap[0], (*iterList).lightmap[0]);
-
-			qglTexCoord2fv( ( *iterList ).st );
-			qglVertex3fv( ( *iterList ).xyz );
-
-			//if (g_PrefsDlg.m_bGLLighting)
-			qglNormal3fv( ( *iterListNext ).normal );
-			//else if (bShade && !g_PrefsDlg.m_bDisplayLists)
-			//	qglColor3f((*iterListNext).lightmap[0], (*iterListNext).lightmap[0], (*iterListNext).lightmap[0]);
-
-			qglTexCoord2fv( ( *iterListNext ).st );
-			qglVertex3fv( ( *iterListNext ).xyz );
-		}
-		qglEnd();
+		//  qglDrawElements(GL_TRIANGLE_STRIP, ...);
 	}
-/*
-   #ifdef _DEBUG
-   vec3_t vNormal;
-   for (iterLists=drawLists->begin(); iterLists != drawLists->end(); iterLists++)
-   {
-        qglBegin (GL_LINES); // draw normals
-        //qglColor3f(1,1,1);
-        for (iterList=(*iterLists)->begin(); iterList != (*iterLists)->end(); iterList++)
-        {
-            VectorAdd((*iterList).xyz, (*iterList).normal, vNormal);
-            qglVertex3fv ((*iterList).xyz);
-            qglVertex3fv (vNormal);
-        }
-        qglEnd ();
-   }
-
-    Patch_DrawNormals(patch);
 
-   #endif
- */
+	qglPopClientAttrib();
 }
 
 /*
@@ -3258,10 +3323,9 @@ int Triangle_Ray( float orig[3], float dir[3], bool bCullBack,
 }
 
 bool Patch_Ray( patchMesh_t *patch, vec3_t origin, vec3_t dir, double *t, double *u, double *v ){
-	drawLists_t *drawLists;
-
-	drawLists_t::iterator iterLists, iterListsNext;
-	drawList_t::iterator i1, i2, i3, i4;
+	patchTess_t *tess;
+	int i, j, count;
+	drawVert_t *r1, *r2;
 
 //  vec3_t tris[2][3];
 	bool bIntersect = false;
@@ -3271,35 +3335,28 @@ bool Patch_Ray( patchMesh_t *patch, vec3_t origin, vec3_t dir, double *t, double
 		return false;
 	}
 
-	drawLists = (drawLists_t *)patch->drawLists;
+	tess = (patchTess_t *)patch->drawLists;
 
-	iterListsNext = drawLists->begin();
-	iterListsNext++;
-	for ( iterLists = drawLists->begin(); iterLists != drawLists->end() && iterListsNext != drawLists->end(); iterLists++, iterListsNext++ )
+	for ( i = 0; i + 1 < tess->numRows; i++ )
 	{
-		// traverse two drawlists at once with two iterators each to triangulate
-		i1 = i3 = ( *iterLists )->begin();
-		i2 = i4 = ( *iterListsNext )->begin();
-		i3++;
-		i4++;
-		while ( i3 != ( *iterLists )->end() && i4 != ( *iterListsNext )->end() )
+		// traverse two rows at once to triangulate
+		r1 = tess->verts + tess->rowStart[i];
+		r2 = tess->verts + tess->rowStart[i + 1];
+		count = ( tess->stripStart[i + 1] - tess->stripStart[i] ) / 2;
+		for ( j = 0; j + 1 < count; j++ )
 		{
-			if ( Triangle_Ray( origin, dir, false, ( *i1 ).xyz, ( *i2 ).xyz, ( *i3 ).xyz, t, u, v ) ) {
+			if ( Triangle_Ray( origin, dir, false, r1[j].xyz, r2[j].xyz, r1[j + 1].xyz, t, u, v ) ) {
 				bIntersect = true;
 				if ( *t < tBest ) {
 					tBest = *t;
 				}
 			}
-			if ( Triangle_Ray( origin, dir, false, ( *i3 ).xyz, ( *i4 ).xyz, ( *i2 ).xyz, t, u, v ) ) {
+			if ( Triangle_Ray( origin, dir, false, r1[j + 1].xyz, r2[j + 1].xyz, r2[j].xyz, t, u, v ) ) {
 				bIntersect = true;
 				if ( *t < tBest ) {
 					tBest = *t;
 				}
 			}
-			i1++;
-			i2++;
-			i3++;
-			i4++;
 		}
 	}
 	if ( bIntersect ) {
@@ -3349,7 +3406,7 @@ void DrawPatchMesh( patchMesh_t *pm ){
 	}
 	else
 	{
-		if ( pm->bDirty || pm->LODUpdated ) {
+		if ( pm->bDirty || pm->LODUpdated || pm->drawLists == NULL ) {
 			Patch_DeleteDrawLists( pm );
 			Patch_CreateDrawLists( pm );
 			pm->bDirty = false;
@@ -40,6 +40,22 @@ void CPointfile::PushPoint( vec3_t v ){
 	}
 }
 
+GArray *CPointfile::DetachParsed(){
+	GArray *points = m_pParsing;
+
+	m_pParsing = NULL;
+	return points;
+}
+
+void CPointfile::LoadParsed( GArray *points ){
+	guint i;
+
+	Init();
+	for ( i = 0; i < points->len; i++ )
+		PushPoint( g_array_index( points, vec3_t, i ) );
+	GenerateDisplayList();
+}
+
 // create the display list at the end
 void CPointfile::GenerateDisplayList(){
 	int i;
@@ -201,7 +217,11 @@ void Pointfile_Clear( void ){
 // CPointfile implementation for SAX speicific stuff -------------------------------
 void CPointfile::saxStartElement( message_info_t *ctx, const xmlChar *name, const xmlChar **attrs ){
 	if ( strcmp( (char *)name, "polyline" ) == 0 ) {
-		Init();
+		// parse into a fresh buffer, the points the main thread displays are left alone
+		if ( m_pParsing ) {
+			g_array_free( m_pParsing, TRUE );
+		}
+		m_pParsing = g_array_new( FALSE, FALSE, sizeof( vec3_t ) );
 		// there's a prefs setting to avoid stopping on leak
 		if ( !g_PrefsDlg.m_bLeakStop ) {
 			ctx->stop_depth = 0;
@@ -211,8 +231,7 @@ void CPointfile::saxStartElement( message_info_t *ctx, const xmlChar *name, cons
 
 void CPointfile::saxEndElement( message_info_t *ctx, const xmlChar *name ){
 	if ( strcmp( (char *)name, "polyline" ) == 0 ) {
-		// we are done
-		GenerateDisplayList();
+		// we are done, CWatchBSP hands m_pParsing to the main thread
 		ctx->bGeometry = false;
 	}
 }
@@ -222,7 +241,9 @@ void CPointfile::saxCharacters( message_info_t *ctx, const xmlChar *ch, int len
 	vec3_t v;
 
 	sscanf( (char *)ch, "%f %f %f\n", &v[0], &v[1], &v[2] );
-	PushPoint( v );
+	if ( m_pParsing && m_pParsing->len < MAX_POINTFILE ) {
+		g_array_append_val( m_pParsing, v );
+	}
 }
 
 char * CPointfile::getName(){
@@ -39,10 +39,14 @@ void Pointfile_Load( void );
 class CPointfile : public ISAXHandler
 {
 public:
-CPointfile() { }
+CPointfile() : m_pParsing( NULL ) { }
 void Init();
 void PushPoint( vec3_t v );
 void GenerateDisplayList();
+// CWatchBSP parses the leak line on its worker thread into m_pParsing
+// the finished array is handed over in the feedback event and loaded on the main thread
+GArray *DetachParsed();
+void LoadParsed( GArray *points );
 // SAX interface
 void saxStartElement( message_info_t *ctx, const xmlChar *name, const xmlChar **attrs );
 void saxEndElement( message_info_t *ctx, const xmlChar *name );
@@ -51,6 +55,9 @@ char *getName();
 
 // class is only used for g_pointfile and we should not attempt to free it
 bool ShouldDelete() { return false; }
+
+private:
+GArray *m_pParsing;
 };
 
 // instead of using Pointfile_Load you can do it by hand through g_pointfile
@@ -148,12 +148,14 @@ bool DoesFileExist( const char* pBuff, long& lSize ){
 	return false;
 }
 
-void Map_Snapshot(){
+// returns false if no snapshot was written (or, in the background, started)
+bool Map_Snapshot( bool bBackground ){
 	CString strMsg;
+	bool bSaved = false;
 
 	// I hope the modified flag is kept correctly up to date
 	if ( !modified ) {
-		return;
+		return false;
 	}
 
 	// we need to do the following
@@ -203,7 +205,14 @@ void Map_Snapshot(){
 			nCount++;
 		}
 		// strFile has the next available slot
-		Map_SaveFile( strFile, false );
+		if ( bBackground ) {
+			bSaved = Map_SaveFileInBackground( strFile );
+		}
+		else
+		{
+			Map_SaveFile( strFile, false );
+			bSaved = true;
+		}
 		// it is still a modified map (we enter this only if this is a modified map)
 		Sys_SetTitle( currentmap );
 		Sys_MarkMapModified();
@@ -218,6 +227,7 @@ void Map_Snapshot(){
 	}
 	strOrgPath = "";
 	strOrgFile = "";
+	return bSaved;
 }
 /*
    ===============
@@ -248,16 +258,20 @@ void QE_CheckAutoSave( void ){
 			Sys_Status( strMsg,0 );
 
 			// only snapshot if not working on a default map
+			// the write happens on a worker thread, Map_SaveFileDone reports when it is on disk
+			bool bSaved;
 			if ( g_PrefsDlg.m_bSnapShots && stricmp( currentmap, "unnamed.map" ) != 0 ) {
-				Map_Snapshot();
+				bSaved = Map_Snapshot( true );
 			}
 			else
 			{
-				Map_SaveFile( ValueForKey( g_qeglobals.d_project_entity, "autosave" ), false );
+				bSaved = Map_SaveFileInBackground( ValueForKey( g_qeglobals.d_project_entity, "autosave" ) );
 			}
 
-			Sys_Status( "Autosaving...Saved.", 0 );
-			modified = 2;
+			// a save skipped because the previous one is still running leaves the map unsaved
+			if ( bSaved ) {
+				modified = 2;
+			}
 		}
 		else
 		{
@@ -795,7 +795,7 @@ extern void QE_CheckAutoSave();
 extern qtexture_t   *current_texture;
 extern void SaveWithRegion( char *name ); // save the current map, sets the map name in the name buffer (deals with regioning)
 extern void RunBsp( char *command );
-extern void Map_Snapshot();
+extern bool Map_Snapshot( bool bBackground = false );
 extern void WXY_Print();
 extern void AddProp( void );
 extern qboolean DoColor( int iIndex );
@@ -882,6 +882,11 @@ int GetUniqueTargetId( int iHint );
 
 // xywindow.cpp
 void CreateEntityFromName( const char* name, const vec3_t origin );
+// call when brushes are linked into or out of active_brushes without Brush_AddToList / Brush_RemoveFromList
+void XY_InvalidateIndex();
+// call when the windings or bounds of a brush changed
+void XY_InvalidateBrush( brush_t *b );
+void XY_FreeBrushCache( brush_t *b );
 
 // eclass.cpp
 /*!
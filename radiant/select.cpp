@@ -472,6 +472,7 @@ void Select_Deselect( bool bDeselectFaces ){
 	active_brushes.next->prev = selected_brushes.prev;
 	active_brushes.next = selected_brushes.next;
 	selected_brushes.prev = selected_brushes.next = &selected_brushes;
+	XY_InvalidateIndex();
 
 	// filter newly created stuff once it's unselected
 	PerformFiltering();
@@ -2010,6 +2011,7 @@ void Select_Invert( void ){
 		selected_brushes.next = &selected_brushes;
 		selected_brushes.prev = &selected_brushes;
 	}
+	XY_InvalidateIndex();
 
 	// now check if any hidden brush is selected
 	for ( b = selected_brushes.next; b != &selected_brushes; )
@@ -87,7 +87,7 @@ void MakeFace( brush_t* b, face_t *f ){
 	for ( i = 0 ; i < w->numpoints ; i++ )
 		FindEdge( pnum[i], pnum[( i + 1 ) % w->numpoints], f );
 
-	free( w );
+	Winding_Free( w );
 }
 
 void SetupVertexSelection( void ){
@@ -177,7 +177,7 @@ void SelectVertex( int p1 ){
 					break;
 				}
 			}
-			free( w );
+			Winding_Free( w );
 		}
 	}
 }
@@ -52,15 +52,52 @@
 
 #include <assert.h>
 
+// the SAX callbacks run on the CWatchBSP worker thread
+// console output and anything touching the UI is queued for RoutineProcessing
+#define WATCHBSP_QUEUE_SIZE     256     // pending events before the worker waits for the UI
+#define WATCHBSP_TEXT_BATCH     4000    // console text is merged up to this size (Sys_FPrintf formats into 4096 bytes)
+#define WATCHBSP_DRAIN_MAX      64      // events handled per RoutineProcessing call
+
+typedef struct watchEvent_s
+{
+	CWatchBSP::EWatchEvent type;
+	int level;
+	GString *text;
+	ISAXHandler *pHandler;
+	GArray *points;                 // leak line parsed on the worker, for g_pointfile
+} watchEvent_t;
+
+static void WatchEvent_Free( watchEvent_t *event ){
+	if ( event->text ) {
+		g_string_free( event->text, TRUE );
+	}
+	// feedback that never made it to the debug window
+	if ( event->pHandler && event->pHandler->ShouldDelete() ) {
+		delete event->pHandler;
+	}
+	if ( event->points ) {
+		g_array_free( event->points, TRUE );
+	}
+	g_free( event );
+}
+
+void WatchBSP_Printf( int level, const char *text, ... ){
+	va_list args;
+	char *buf;
+
+	va_start( args, text );
+	buf = g_strdup_vprintf( text, args );
+	va_end( args );
+	g_pParentWnd->GetWatchBSP()->QueuePrint( level, buf );
+	g_free( buf );
+}
+
 // Static functions for the SAX callbacks -------------------------------------------------------
 
 // utility for saxStartElement below
 static void abortStream( message_info_t *data ){
-	g_pParentWnd->GetWatchBSP()->Reset();
-	// tell there has been an error
-	if ( g_pParentWnd->GetWatchBSP()->HasBSPPlugin() ) {
-		g_BSPFrontendTable.m_pfnEndListen( 2 );
-	}
+	// the main thread resets the connection and tells there has been an error
+	g_pParentWnd->GetWatchBSP()->QueueEvent( CWatchBSP::EWatchAbort );
 	// yeah this doesn't look good.. but it's needed so that everything will be ignored until the stream goes out
 	data->ignore_depth = -1;
 	data->recurse++;
@@ -81,15 +118,15 @@ static void saxStartElement( message_info_t *data, const xmlChar *name, const xm
 				// old q3map don't send a version attribute
 				// the ones we support .. send Q3MAP_STREAM_VERSION
 				if ( !attrs[0] || !attrs[1] || ( strcmp( (char*)attrs[0],"version" ) != 0 ) ) {
-					Sys_FPrintf( SYS_ERR, "No stream version given in the feedback stream, this is an old q3map version.\n"
+					WatchBSP_Printf( SYS_ERR, "No stream version given in the feedback stream, this is an old q3map version.\n"
 										  "Please turn off monitored compiling if you still wish to use this q3map executable\n" );
 					abortStream( data );
 					return;
 				}
 				else if ( strcmp( (char*)attrs[1],Q3MAP_STREAM_VERSION ) != 0 ) {
-					Sys_FPrintf( SYS_ERR,
-								 "This version of Radiant reads version %s debug streams, I got an incoming connection with version %s\n"
-								 "Please make sure your versions of Radiant and q3map are matching.\n", Q3MAP_STREAM_VERSION, (char*)attrs[1] );
+					WatchBSP_Printf( SYS_ERR,
+									 "This version of Radiant reads version %s debug streams, I got an incoming connection with version %s\n"
+									 "Please make sure your versions of Radiant and q3map are matching.\n", Q3MAP_STREAM_VERSION, (char*)attrs[1] );
 					abortStream( data );
 					return;
 				}
@@ -124,7 +161,7 @@ static void saxStartElement( message_info_t *data, const xmlChar *name, const xm
 			}
 			else
 			{
-				Sys_FPrintf( SYS_WRN, "WARNING: ignoring unrecognized node in XML stream (%s)\n", name );
+				WatchBSP_Printf( SYS_WRN, "WARNING: ignoring unrecognized node in XML stream (%s)\n", name );
 				// we don't recognize this node, jump over it
 				// (NOTE: the ignore mechanism is a bit screwed, only works when starting an ignore at the highest level)
 				data->ignore_depth = data->recurse;
@@ -145,17 +182,17 @@ static void saxEndElement( message_info_t *data, const xmlChar *name ) {
 		data->pGeometry->saxEndElement( data, name );
 		// we add the object to the debug window
 		if ( !data->bGeometry ) {
-			g_DbgDlg.Push( data->pGeometry );
+			// the leak line travels with the event, g_pointfile itself belongs to the main thread
+			g_pParentWnd->GetWatchBSP()->QueueEvent( CWatchBSP::EWatchFeedback, data->pGeometry,
+													 data->pGeometry == &g_pointfile ? g_pointfile.DetachParsed() : NULL );
 		}
 	}
 	if ( data->recurse == data->stop_depth ) {
 #ifdef _DEBUG
-		Sys_Printf( "Received error msg .. shutting down..\n" );
+		WatchBSP_Printf( SYS_STD, "Received error msg .. shutting down..\n" );
 #endif
 		// tell there has been an error
-		if ( g_pParentWnd->GetWatchBSP()->HasBSPPlugin() ) {
-			g_BSPFrontendTable.m_pfnEndListen( 2 );
-		}
+		g_pParentWnd->GetWatchBSP()->QueueEvent( CWatchBSP::EWatchStop );
 		return;
 	}
 }
@@ -170,10 +207,7 @@ static void saxCharacters( message_info_t *data, const xmlChar *ch, int len ){
 			return;
 		}
 		// output the message using the level
-		char buf[1024];
-		memcpy( buf, ch, len );
-		buf[len] = '\0';
-		Sys_FPrintf( data->msg_level, "%s", buf );
+		g_pParentWnd->GetWatchBSP()->QueuePrint( data->msg_level, (const char *)ch, len );
 		// if this message has error level flag, we mark the depth to stop the compilation when we get out
 		// we don't set the msg level if we don't stop on leak
 		if ( data->msg_level == 3 ) {
@@ -183,7 +217,7 @@ static void saxCharacters( message_info_t *data, const xmlChar *ch, int len ){
 }
 
 static void saxComment( void *ctx, const xmlChar *msg ){
-	Sys_Printf( "XML comment: %s\n", msg );
+	WatchBSP_Printf( SYS_STD, "XML comment: %s\n", msg );
 }
 
 static void saxWarning( void *ctx, const char *msg, ... ){
@@ -193,7 +227,7 @@ static void saxWarning( void *ctx, const char *msg, ... ){
 	va_start( args, msg );
 	vsprintf( saxMsgBuffer, msg, args );
 	va_end( args );
-	Sys_FPrintf( SYS_WRN, "XML warning: %s\n", saxMsgBuffer );
+	WatchBSP_Printf( SYS_WRN, "XML warning: %s\n", saxMsgBuffer );
 }
 
 static void saxError( void *ctx, const char *msg, ... ){
@@ -203,7 +237,7 @@ static void saxError( void *ctx, const char *msg, ... ){
 	va_start( args, msg );
 	vsprintf( saxMsgBuffer, msg, args );
 	va_end( args );
-	Sys_FPrintf( SYS_ERR, "XML error: %s\n", saxMsgBuffer );
+	WatchBSP_Printf( SYS_ERR, "XML error: %s\n", saxMsgBuffer );
 }
 
 static void saxFatal( void *ctx, const char *msg, ... ){
@@ -214,7 +248,7 @@ static void saxFatal( void *ctx, const char *msg, ... ){
 	va_start( args, msg );
 	vsprintf( buffer, msg, args );
 	va_end( args );
-	Sys_FPrintf( SYS_ERR, "XML fatal error: %s\n", buffer );
+	WatchBSP_Printf( SYS_ERR, "XML fatal error: %s\n", buffer );
 }
 
 static xmlSAXHandler saxParser = {
@@ -335,6 +369,9 @@ void CWatchBSP::RunQuake() {
 }
 
 void CWatchBSP::Reset(){
+	// the worker owns the socket and the parser while it runs
+	StopWatching();
+
 	if ( m_pInSocket ) {
 		Net_Disconnect( m_pInSocket );
 		m_pInSocket = NULL;
@@ -415,17 +452,262 @@ void CWatchBSP::DoEBeginStep() {
 	m_eState = EBeginStep;
 }
 
-void CWatchBSP::RoutineProcessing(){
+// worker side ----------------------------------------------------------------------------------
+
+void CWatchBSP::QueuePrint( int level, const char *text, int len ){
+	if ( len < 0 ) {
+		len = strlen( text );
+	}
+	if ( level != m_iTextLevel || m_pText->len + len > WATCHBSP_TEXT_BATCH ) {
+		FlushText();
+		m_iTextLevel = level;
+	}
+	g_string_append_len( m_pText, text, len );
+}
+
+void CWatchBSP::FlushText(){
+	watchEvent_t *event;
+
+	if ( m_pText->len == 0 ) {
+		return;
+	}
+
+	event = g_new0( watchEvent_t, 1 );
+	event->type = EWatchText;
+	event->level = m_iTextLevel;
+	event->text = m_pText;
+	m_pText = g_string_new( NULL );
+
+	// keep the queue bounded, this also throttles the compiler through the socket
+	while ( g_async_queue_length( m_pQueue ) >= WATCHBSP_QUEUE_SIZE && !g_atomic_int_get( &m_bCancel ) )
+		g_usleep( 10000 );
+	g_async_queue_push( m_pQueue, event );
+}
+
+void CWatchBSP::QueueEvent( EWatchEvent type, ISAXHandler *pHandler, GArray *pPoints ){
+	watchEvent_t *event;
+
+	// keep the order with the text before it
+	FlushText();
+
+	event = g_new0( watchEvent_t, 1 );
+	event->type = type;
+	event->pHandler = pHandler;
+	event->points = pPoints;
+
+	while ( g_async_queue_length( m_pQueue ) >= WATCHBSP_QUEUE_SIZE && !g_atomic_int_get( &m_bCancel ) )
+		g_usleep( 10000 );
+	g_async_queue_push( m_pQueue, event );
+}
+
+gpointer CWatchBSP::WatchThread( gpointer data ){
+	( (CWatchBSP *)data )->Watch();
+	return NULL;
+}
+
+void CWatchBSP::Watch(){
 	// used for select()
 #ifdef _WIN32
-	TIMEVAL tout = { 0, 0 };
+	TIMEVAL tout;
 #endif
 #if defined ( __linux__ ) || defined ( __APPLE__ )
 	timeval tout;
-	tout.tv_sec = 0;
-	tout.tv_usec = 0;
 #endif
+	fd_set readfds;
+	int ret;
+
+	while ( !g_atomic_int_get( &m_bCancel ) )
+	{
+		// select() will identify if the socket needs an update
+		// if the socket is identified that means there's either a message or the connection has been closed/reset/terminated
+		// batched text goes out as soon as nothing else is waiting, otherwise wake up regularly to see if we were cancelled
+		tout.tv_sec = 0;
+		tout.tv_usec = 0;
+		FD_ZERO( &readfds );
+		FD_SET( ( (unsigned int)m_pInSocket->socket ), &readfds );
+		// from select man page:
+		// n is the highest-numbered descriptor in any of the three sets, plus 1
+		// (no use on windows)
+		ret = select( m_pInSocket->socket + 1, &readfds, NULL, NULL, &tout );
+		if ( ret == 0 ) {
+			FlushText();
+			tout.tv_sec = 0;
+			tout.tv_usec = 100000;
+			FD_ZERO( &readfds );
+			FD_SET( ( (unsigned int)m_pInSocket->socket ), &readfds );
+			ret = select( m_pInSocket->socket + 1, &readfds, NULL, NULL, &tout );
+		}
+		if ( ret == SOCKET_ERROR ) {
+			QueuePrint( SYS_STD, "WARNING: SOCKET_ERROR in CWatchBSP::Watch\nTerminating the connection.\n" );
+			QueueEvent( EWatchReset );
+			return;
+		}
+		if ( ret != 1 ) {
+			continue;
+		}
+
+		// the socket has been identified, there's something (message or disconnection)
+		// see if there's anything in input
+		ret = Net_Receive( m_pInSocket, &msg );
+		if ( ret <= 0 ) {
+			// error or connection closed/reset
+			// NOTE: if we get an error down the XML stream we don't reach here
+			QueueEvent( EWatchClosed );
+			return;
+		}
+
+		//        unsigned int size = msg.size; //++timo just a check
+		g_strlcpy( m_xmlBuf, NMSG_ReadString( &msg ), sizeof( m_xmlBuf) );
+		if ( m_xmlParserCtxt == NULL ) {
+			m_xmlParserCtxt = xmlCreatePushParserCtxt( &saxParser, &m_message_info, m_xmlBuf, strlen( m_xmlBuf ), NULL );
+			if ( m_xmlParserCtxt == NULL ) {
+				WatchBSP_Printf( SYS_ERR, "Failed to create the XML parser (incoming stream began with: %s)\n", m_xmlBuf );
+				QueueEvent( EWatchReset );
+				return;
+			}
+		}
+		else
+		{
+			xmlParseChunk( m_xmlParserCtxt, m_xmlBuf, strlen( m_xmlBuf ), 0 );
+		}
+
+		// abortStream queued the reset, the rest of the stream is ignored
+		if ( m_message_info.ignore_depth == -1 ) {
+			FlushText();
+			return;
+		}
+	}
+}
+
+// main thread side -----------------------------------------------------------------------------
+
+void CWatchBSP::StartWatching(){
+	// prepare the message info struct for diving in
+	memset( &m_message_info, 0, sizeof( message_info_s ) );
+
+	m_pQueue = g_async_queue_new();
+	m_pText = g_string_new( NULL );
+	m_iTextLevel = SYS_STD;
+	g_atomic_int_set( &m_bCancel, 0 );
+
+	// libxml wants this done once before parsing from other threads
+	xmlInitParser();
+
+#if GLIB_CHECK_VERSION( 2, 32, 0 )
+	m_pThread = g_thread_try_new( "watchbsp", WatchThread, this, NULL );
+#else
+	m_pThread = g_thread_create( WatchThread, this, TRUE, NULL );
+#endif
+	if ( !m_pThread ) {
+		Sys_FPrintf( SYS_ERR, "Failed to start the BSP monitoring thread\n" );
+		Reset();
+		return;
+	}
 
+	m_eState = EWatching;
+}
+
+void CWatchBSP::StopWatching(){
+	watchEvent_t *event;
+
+	if ( m_pThread ) {
+		g_atomic_int_set( &m_bCancel, 1 );
+		g_thread_join( m_pThread );
+		m_pThread = NULL;
+	}
+
+	// whatever the UI did not get to yet is dropped
+	if ( m_pQueue ) {
+		while ( ( event = (watchEvent_t *)g_async_queue_try_pop( m_pQueue ) ) != NULL )
+			WatchEvent_Free( event );
+		g_async_queue_unref( m_pQueue );
+		m_pQueue = NULL;
+	}
+	if ( m_pText ) {
+		g_string_free( m_pText, TRUE );
+		m_pText = NULL;
+	}
+}
+
+void CWatchBSP::ProcessEvents(){
+	watchEvent_t *event;
+	int i;
+
+	// a bounded amount per call so a flood of feedback can't starve the UI
+	for ( i = 0; i < WATCHBSP_DRAIN_MAX && m_pQueue; i++ )
+	{
+		event = (watchEvent_t *)g_async_queue_try_pop( m_pQueue );
+		if ( !event ) {
+			break;
+		}
+
+		switch ( event->type )
+		{
+		case EWatchText:
+			Sys_FPrintf( event->level, "%s", event->text->str );
+			break;
+
+		case EWatchFeedback:
+			// the leak line needs a GL context
+			if ( event->points ) {
+				g_pointfile.LoadParsed( event->points );
+			}
+			g_DbgDlg.Push( event->pHandler );
+			event->pHandler = NULL;
+			break;
+
+		case EWatchStop:
+			// tell there has been an error
+			if ( m_bBSPPlugin ) {
+				g_BSPFrontendTable.m_pfnEndListen( 2 );
+			}
+			break;
+
+		case EWatchAbort:
+			Reset();
+			// tell there has been an error
+			if ( m_bBSPPlugin ) {
+				g_BSPFrontendTable.m_pfnEndListen( 2 );
+			}
+			break;
+
+		case EWatchReset:
+			Reset();
+			break;
+
+		case EWatchClosed:
+			Reset();
+			Sys_Printf( "Connection closed.\n" );
+			if ( m_bBSPPlugin ) {
+				// let the BSP plugin know that the job is done
+				g_BSPFrontendTable.m_pfnEndListen( 0 );
+			}
+
+			// move to next step or finish
+			m_iCurrentStep++;
+			if ( m_iCurrentStep < m_pCmd->len ) {
+				DoEBeginStep();
+				break;
+			}
+
+			// launch the engine .. OMG
+			if ( g_PrefsDlg.m_bRunQuake ) {
+				// do we enter sleep mode before?
+				if ( g_PrefsDlg.m_bDoSleep ) {
+					Sys_Printf( "Going into sleep mode..\n" );
+					g_pParentWnd->OnSleep();
+				}
+				Sys_Printf( "Running engine...\n" );
+				RunQuake();
+			}
+			break;
+		}
+
+		WatchEvent_Free( event );
+	}
+}
+
+void CWatchBSP::RoutineProcessing(){
 	switch ( m_eState )
 	{
 	case EBeginStep:
@@ -451,10 +733,8 @@ void CWatchBSP::RoutineProcessing(){
 		m_pInSocket = Net_Accept( m_pListenSocket );
 		if ( m_pInSocket ) {
 			Sys_Printf( "Connected.\n" );
-			// prepare the message info struct for diving in
-			memset( &m_message_info, 0, sizeof( message_info_s ) );
-			// a dumb flag to make sure we init the push parser context when first getting a msg
-			m_eState = EWatching;
+			// from now on the worker reads the connection
+			StartWatching();
 		}
 		break;
 
@@ -467,75 +747,7 @@ void CWatchBSP::RoutineProcessing(){
 			break;
 		}
 #endif
-		// select() will identify if the socket needs an update
-		// if the socket is identified that means there's either a message or the connection has been closed/reset/terminated
-		fd_set readfds;
-		int ret;
-		FD_ZERO( &readfds );
-		FD_SET( ( (unsigned int)m_pInSocket->socket ), &readfds );
-		// from select man page:
-		// n is the highest-numbered descriptor in any of the three sets, plus 1
-		// (no use on windows)
-		ret = select( m_pInSocket->socket + 1, &readfds, NULL, NULL, &tout );
-		if ( ret == SOCKET_ERROR ) {
-			Sys_Printf( "WARNING: SOCKET_ERROR in CWatchBSP::RoutineProcessing\n" );
-			Sys_Printf( "Terminating the connection.\n" );
-			Reset();
-			break;
-		}
-		if ( ret == 1 ) {
-			// the socket has been identified, there's something (message or disconnection)
-			// see if there's anything in input
-			ret = Net_Receive( m_pInSocket, &msg );
-			if ( ret > 0 ) {
-				//        unsigned int size = msg.size; //++timo just a check
-				g_strlcpy( m_xmlBuf, NMSG_ReadString( &msg ), sizeof( m_xmlBuf) );
-				if ( m_xmlParserCtxt == NULL ) {
-					m_xmlParserCtxt = xmlCreatePushParserCtxt( &saxParser, &m_message_info, m_xmlBuf, strlen( m_xmlBuf ), NULL );
-					if ( m_xmlParserCtxt == NULL ) {
-						Sys_FPrintf( SYS_ERR, "Failed to create the XML parser (incoming stream began with: %s)\n", m_xmlBuf );
-						Reset();
-						break;
-					}
-				}
-				else
-				{
-					xmlParseChunk( m_xmlParserCtxt, m_xmlBuf, strlen( m_xmlBuf ), 0 );
-				}
-			}
-			else
-			{
-				// error or connection closed/reset
-				// NOTE: if we get an error down the XML stream we don't reach here
-				Net_Disconnect( m_pInSocket );
-				m_pInSocket = NULL;
-				Sys_Printf( "Connection closed.\n" );
-				if ( m_bBSPPlugin ) {
-					// let the BSP plugin know that the job is done
-					g_BSPFrontendTable.m_pfnEndListen( 0 );
-				}
-
-				Reset();
-
-				// move to next step or finish
-				m_iCurrentStep++;
-				if ( m_iCurrentStep < m_pCmd->len ) {
-					DoEBeginStep();
-					break;
-				}
-
-				// launch the engine .. OMG
-				if ( g_PrefsDlg.m_bRunQuake ) {
-					// do we enter sleep mode before?
-					if ( g_PrefsDlg.m_bDoSleep ) {
-						Sys_Printf( "Going into sleep mode..\n" );
-						g_pParentWnd->OnSleep();
-					}
-					Sys_Printf( "Running engine...\n" );
-					RunQuake();
-				}
-			}
-		}
+		ProcessEvents();
 		break;
 	default:
 		break;
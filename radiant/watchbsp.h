@@ -71,15 +71,38 @@ void DoEBeginStep();
 char m_xmlBuf[MAX_NETMESSAGE];
 bool m_bNeedCtxtInit;
 message_info_s m_message_info;
+// in EWatching the connection is read and parsed on a worker thread
+// the SAX callbacks never touch the UI, they queue events that RoutineProcessing handles
+GThread *m_pThread;
+gint m_bCancel;
+// bounded: the worker waits when the UI falls behind
+GAsyncQueue *m_pQueue;
+// console text is batched on the worker before it is queued
+GString *m_pText;
+int m_iTextLevel;
+// worker side
+static gpointer WatchThread( gpointer data );
+void Watch();
+void FlushText();
+// main thread side
+void StartWatching();
+void StopWatching();
+void ProcessEvents();
 
 public:
-CWatchBSP() { m_bBSPPlugin = false; m_pListenSocket = NULL; m_pInSocket = NULL; m_eState = EIdle; m_pTimer = g_timer_new(); m_sBSPName = NULL; m_pCmd = NULL; m_iCurrentStep = 0; m_xmlInputBuffer = NULL; m_xmlParserCtxt = NULL; }
+// what the worker asks the main thread to do
+enum EWatchEvent { EWatchText, EWatchFeedback, EWatchStop, EWatchAbort, EWatchReset, EWatchClosed };
+
+CWatchBSP() { m_bBSPPlugin = false; m_pListenSocket = NULL; m_pInSocket = NULL; m_eState = EIdle; m_pTimer = g_timer_new(); m_sBSPName = NULL; m_pCmd = NULL; m_iCurrentStep = 0; m_xmlInputBuffer = NULL; m_xmlParserCtxt = NULL; m_pThread = NULL; m_bCancel = 0; m_pQueue = NULL; m_pText = NULL; m_iTextLevel = SYS_STD; }
 virtual ~CWatchBSP();
 bool HasBSPPlugin() const
 { return m_bBSPPlugin; }
 
 // called regularly to keep listening
 void RoutineProcessing();
+// used by the SAX callbacks on the worker thread instead of Sys_FPrintf / direct UI calls
+void QueuePrint( int level, const char *text, int len = -1 );
+void QueueEvent( EWatchEvent type, ISAXHandler *pHandler = NULL, GArray *pPoints = NULL );
 // start a monitoring loop with the following steps
 void DoMonitoringLoop( GPtrArray *pCmd, char *sBSPName );
 // close everything - may be called from the outside to abort the process
@@ -90,4 +113,7 @@ void ExternalListen();
 
 void WINAPI QERApp_Listen();
 
+// console output for the SAX handlers, they run on the CWatchBSP worker thread
+void WatchBSP_Printf( int level, const char *text, ... );
+
 #endif
@@ -190,16 +190,20 @@ winding_t *Winding_Alloc( int points ){
 	}
 
 //	size = (int)((winding_t *)0)->points[points];
+	// windings come and go constantly (every build, clip and split), so they
+	// live in slices sized by maxpoints rather than on the general heap
 	size = WINDING_SIZE( points );
-	w = (winding_t*) malloc( size );
-	memset( w, 0, size );
+	w = (winding_t*) g_slice_alloc0( size );
 	w->maxpoints = points;
 
 	return w;
 }
 
 void Winding_Free( winding_t *w ){
-	free( w );
+	if ( !w ) {
+		return;
+	}
+	g_slice_free1( WINDING_SIZE( w->maxpoints ), w );
 }
 
 /*
@@ -213,8 +217,9 @@ winding_t *Winding_Clone( winding_t *w ){
 
 //	size = (int)((winding_t *)0)->points[w->numpoints];
 	size = WINDING_SIZE( w->numpoints );
-	c = (winding_t*)qmalloc( size );
+	c = (winding_t*)g_slice_alloc( size );
 	memcpy( c, w, size );
+	c->maxpoints = w->numpoints;
 	return c;
 }
 
@@ -609,6 +609,292 @@ bool OnList( entity_t* pFind, CPtrArray* pList ){
 	return false;
 }
 
+// =============================================================================
+// 2D view brush index
+
+// active_brushes are bucketed into a coarse grid per view type, so XY_Draw only visits
+// the cells on screen. every brush keeps its outline for each view type as a GL_LINES
+// vertex array, built on first draw and dropped by XY_InvalidateBrush, and the visible
+// outlines are batched by colour into one glDrawArrays call per colour.
+// changes to the active_brushes membership rebuild the whole index on the next draw.
+
+#define XY_INDEX_CELL       1024    // world units per grid cell
+#define XY_INDEX_MAX_CELLS  64      // brushes covering more cells go to the large list
+
+typedef struct xyBrushCache_s
+{
+	int generation;                 // index generation the brush was bucketed in
+	int stamp;                      // last query that returned it
+	float *lines[3];                // outline per view type, xyz pairs for GL_LINES
+	int numVerts[3];                // -1 until the outline is built
+} xyBrushCache_t;
+
+typedef struct xyBrushIndex_s
+{
+	int width, height;
+	GPtrArray **cells;              // width * height, allocated on demand
+	GPtrArray *large;
+} xyBrushIndex_t;
+
+static xyBrushIndex_t s_xyIndex[3]; // per VIEWTYPE
+static bool s_bXYIndexDirty = true;
+static int s_nXYIndexGeneration = 0;
+static int s_nXYIndexStamp = 0;
+static int s_nXYIndexed = 0;
+
+// brush -> xyBrushCache_t, kept here rather than in brush_t so the plugin visible struct is unchanged
+static GHashTable *s_xyBrushCaches = NULL;
+
+void XY_InvalidateIndex(){
+	s_bXYIndexDirty = true;
+}
+
+static xyBrushCache_t *XY_FindBrushCache( brush_t *b ){
+	if ( !s_xyBrushCaches ) {
+		return NULL;
+	}
+	return (xyBrushCache_t *)g_hash_table_lookup( s_xyBrushCaches, b );
+}
+
+static xyBrushCache_t *XY_BrushCache( brush_t *b ){
+	xyBrushCache_t *cache = XY_FindBrushCache( b );
+	if ( !cache ) {
+		if ( !s_xyBrushCaches ) {
+			s_xyBrushCaches = g_hash_table_new( g_direct_hash, g_direct_equal );
+		}
+		cache = (xyBrushCache_t *)qmalloc( sizeof( xyBrushCache_t ) );
+		cache->numVerts[0] = cache->numVerts[1] = cache->numVerts[2] = -1;
+		g_hash_table_insert( s_xyBrushCaches, b, cache );
+	}
+	return cache;
+}
+
+void XY_InvalidateBrush( brush_t *b ){
+	xyBrushCache_t *cache = XY_FindBrushCache( b );
+	if ( !cache ) {
+		return;
+	}
+	for ( int i = 0; i < 3; i++ )
+	{
+		free( cache->lines[i] );
+		cache->lines[i] = NULL;
+		cache->numVerts[i] = -1;
+	}
+	// the bounds may have changed, bucket it again
+	if ( cache->generation == s_nXYIndexGeneration ) {
+		s_bXYIndexDirty = true;
+	}
+}
+
+void XY_FreeBrushCache( brush_t *b ){
+	xyBrushCache_t *cache = XY_FindBrushCache( b );
+	if ( !cache ) {
+		return;
+	}
+	// the index still points to it
+	if ( cache->generation == s_nXYIndexGeneration ) {
+		s_bXYIndexDirty = true;
+	}
+	for ( int i = 0; i < 3; i++ )
+		free( cache->lines[i] );
+	free( cache );
+	g_hash_table_remove( s_xyBrushCaches, b );
+}
+
+static void XY_IndexCellRange( float min, float max, int size, int &first, int &last ){
+	first = (int)floor( ( min - g_MinWorldCoord ) / XY_INDEX_CELL );
+	last = (int)floor( ( max - g_MinWorldCoord ) / XY_INDEX_CELL );
+	if ( first < 0 ) {
+		first = 0;
+	}
+	if ( last >= size ) {
+		last = size - 1;
+	}
+}
+
+static void XY_RebuildIndex(){
+	brush_t *b;
+	int nViewType, x, y, x1, x2, y1, y2, size;
+
+	s_nXYIndexGeneration++;
+	s_nXYIndexed = 0;
+
+	size = ( g_MaxWorldCoord - g_MinWorldCoord ) / XY_INDEX_CELL + 1;
+	for ( nViewType = 0; nViewType < 3; nViewType++ )
+	{
+		xyBrushIndex_t *index = &s_xyIndex[nViewType];
+		if ( index->width != size ) {
+			// first use, or the world size changed with the game
+			if ( index->cells ) {
+				for ( x = 0; x < index->width * index->height; x++ )
+					if ( index->cells[x] ) {
+						g_ptr_array_free( index->cells[x], TRUE );
+					}
+				free( index->cells );
+			}
+			index->width = index->height = size;
+			index->cells = (GPtrArray **)qmalloc( size * size * sizeof( GPtrArray * ) );
+		}
+		else
+		{
+			for ( x = 0; x < index->width * index->height; x++ )
+				if ( index->cells[x] ) {
+					g_ptr_array_set_size( index->cells[x], 0 );
+				}
+		}
+		if ( !index->large ) {
+			index->large = g_ptr_array_new();
+		}
+		g_ptr_array_set_size( index->large, 0 );
+	}
+
+	for ( b = active_brushes.next ; b != NULL && b != &active_brushes ; b = b->next )
+	{
+		XY_BrushCache( b )->generation = s_nXYIndexGeneration;
+		s_nXYIndexed++;
+
+		for ( nViewType = 0; nViewType < 3; nViewType++ )
+		{
+			xyBrushIndex_t *index = &s_xyIndex[nViewType];
+			int nDim1 = ( nViewType == YZ ) ? 1 : 0;
+			int nDim2 = ( nViewType == XY ) ? 1 : 2;
+
+			XY_IndexCellRange( b->mins[nDim1], b->maxs[nDim1], index->width, x1, x2 );
+			XY_IndexCellRange( b->mins[nDim2], b->maxs[nDim2], index->height, y1, y2 );
+			if ( x1 > x2 || y1 > y2 ) {
+				continue; // no windings
+			}
+			if ( ( x2 - x1 + 1 ) * ( y2 - y1 + 1 ) > XY_INDEX_MAX_CELLS ) {
+				g_ptr_array_add( index->large, b );
+				continue;
+			}
+			for ( y = y1; y <= y2; y++ )
+				for ( x = x1; x <= x2; x++ )
+				{
+					GPtrArray **cell = &index->cells[y * index->width + x];
+					if ( !*cell ) {
+						*cell = g_ptr_array_new();
+					}
+					g_ptr_array_add( *cell, b );
+				}
+		}
+	}
+
+	s_bXYIndexDirty = false;
+}
+
+static void XY_IndexQueryAdd( brush_t *b, const vec3_t mins, const vec3_t maxs, int nDim1, int nDim2, GPtrArray *visible ){
+	xyBrushCache_t *cache = XY_FindBrushCache( b );
+
+	if ( cache->stamp == s_nXYIndexStamp ) {
+		return; // already seen in another cell
+	}
+	cache->stamp = s_nXYIndexStamp;
+
+	if ( b->bFiltered ) {
+		return;
+	}
+	if ( b->mins[nDim1] > maxs[0] ||
+		 b->mins[nDim2] > maxs[1] ||
+		 b->maxs[nDim1] < mins[0] ||
+		 b->maxs[nDim2] < mins[1] ) {
+		return; // off screen
+	}
+	g_ptr_array_add( visible, b );
+}
+
+// fills visible with the unfiltered active brushes overlapping the view rectangle
+static void XY_IndexQuery( int nViewType, const vec3_t mins, const vec3_t maxs, GPtrArray *visible ){
+	xyBrushIndex_t *index;
+	int nDim1 = ( nViewType == YZ ) ? 1 : 0;
+	int nDim2 = ( nViewType == XY ) ? 1 : 2;
+	int x, y, x1, x2, y1, y2;
+	unsigned int i;
+
+	if ( s_bXYIndexDirty ) {
+		XY_RebuildIndex();
+	}
+	s_nXYIndexStamp++;
+
+	index = &s_xyIndex[nViewType];
+	XY_IndexCellRange( mins[0], maxs[0], index->width, x1, x2 );
+	XY_IndexCellRange( mins[1], maxs[1], index->height, y1, y2 );
+	for ( y = y1; y <= y2; y++ )
+		for ( x = x1; x <= x2; x++ )
+		{
+			GPtrArray *cell = index->cells[y * index->width + x];
+			if ( cell ) {
+				for ( i = 0; i < cell->len; i++ )
+					XY_IndexQueryAdd( (brush_t *)g_ptr_array_index( cell, i ), mins, maxs, nDim1, nDim2, visible );
+			}
+		}
+	for ( i = 0; i < index->large->len; i++ )
+		XY_IndexQueryAdd( (brush_t *)g_ptr_array_index( index->large, i ), mins, maxs, nDim1, nDim2, visible );
+}
+
+// outline of the faces Brush_DrawXY would draw for this view type
+static void XY_BuildBrushLines( brush_t *b, int nViewType ){
+	xyBrushCache_t *cache = XY_BrushCache( b );
+	face_t *face;
+	winding_t *w;
+	int i, numVerts;
+	float *v;
+
+	numVerts = 0;
+	for ( face = b->brush_faces ; face ; face = face->next )
+		if ( face->face_winding ) {
+			numVerts += face->face_winding->numpoints * 2;
+		}
+
+	free( cache->lines[nViewType] );
+	cache->lines[nViewType] = v = (float *)malloc( numVerts * 3 * sizeof( float ) + 1 );
+	numVerts = 0;
+	for ( face = b->brush_faces ; face ; face = face->next )
+	{
+		w = face->face_winding;
+		if ( !w ) {
+			continue;
+		}
+		// only polygons facing in a direction we care about, as in Brush_DrawXY
+		if ( nViewType == XY ) {
+			if ( face->plane.normal[2] <= 0 ) {
+				continue;
+			}
+		}
+		else if ( nViewType == XZ ) {
+			if ( face->plane.normal[1] >= 0 ) { // stop axes being mirrored
+				continue;
+			}
+		}
+		else if ( face->plane.normal[0] <= 0 ) {
+			continue;
+		}
+
+		// the line loop as separate segments
+		for ( i = 0 ; i < w->numpoints ; i++ )
+		{
+			VectorCopy( w->points[i], v );
+			VectorCopy( w->points[( i + 1 ) % w->numpoints], v + 3 );
+			v += 6;
+			numVerts += 2;
+		}
+	}
+	cache->numVerts[nViewType] = numVerts;
+}
+
+static const float *XY_BrushColor( brush_t *b ){
+	if ( b->owner != world_entity && b->owner ) {
+		return b->owner->eclass->color;
+	}
+	return g_qeglobals.d_savedinfo.colors[COLOR_BRUSHES];
+}
+
+static int XY_CompareBrushColor( const void *a, const void *b ){
+	const float *ca = XY_BrushColor( *(brush_t **)a );
+	const float *cb = XY_BrushColor( *(brush_t **)b );
+	return ( ca < cb ) ? -1 : ( ca > cb ) ? 1 : 0;
+}
+
 // =============================================================================
 // XYWnd class
 
@@ -2832,29 +3118,26 @@ void XYWnd::XY_Draw(){
 		start2 = Sys_DoubleTime();
 	}
 
-	for ( brush = active_brushes.next ; brush != &active_brushes ; brush = brush->next )
-	{
-		if ( brush->bFiltered ) {
-			continue;
-		}
+	// the spatial index returns the unfiltered brushes on screen
+	static GPtrArray *visible = NULL, *batched = NULL;
+	static float *batch = NULL;
+	static int batchSize = 0;
+	unsigned int j;
 
-		if ( brush->mins[nDim1] > maxs[0] ||
-			 brush->mins[nDim2] > maxs[1] ||
-			 brush->maxs[nDim1] < mins[0] ||
-			 brush->maxs[nDim2] < mins[1] ) {
-			culled++;
-			continue; // off screen
-		}
+	if ( !visible ) {
+		visible = g_ptr_array_new();
+		batched = g_ptr_array_new();
+	}
+	g_ptr_array_set_size( visible, 0 );
+	g_ptr_array_set_size( batched, 0 );
+	XY_IndexQuery( m_nViewType, mins, maxs, visible );
 
-		drawn++;
+	drawn = visible->len;
+	culled = s_nXYIndexed - drawn;
 
-		if ( brush->owner != e && brush->owner ) {
-			qglColor3fv( brush->owner->eclass->color );
-		}
-		else
-		{
-			qglColor3fv( g_qeglobals.d_savedinfo.colors[COLOR_BRUSHES] );
-		}
+	for ( j = 0; j < visible->len; j++ )
+	{
+		brush = (brush_t *)g_ptr_array_index( visible, j );
 
 #ifdef DBG_SCENEDUMP
 		if ( bDump ) {
@@ -2863,9 +3146,53 @@ void XYWnd::XY_Draw(){
 		}
 #endif
 
+		// plain brushes go through the cached outlines, the rest is drawn as before
+		if ( !brush->patchBrush && !brush->owner->eclass->fixedsize ) {
+			if ( XY_FindBrushCache( brush )->numVerts[m_nViewType] < 0 ) {
+				XY_BuildBrushLines( brush, m_nViewType );
+			}
+			g_ptr_array_add( batched, brush );
+			if ( brush->owner != e && brush == brush->owner->brushes.onext ) {
+				qglColor3fv( XY_BrushColor( brush ) );
+				DrawBrushEntityName( brush );
+			}
+			continue;
+		}
+
+		qglColor3fv( XY_BrushColor( brush ) );
 		Brush_DrawXY( brush, m_nViewType );
 	}
 
+	// one vertex array per colour
+	qsort( batched->pdata, batched->len, sizeof( gpointer ), XY_CompareBrushColor );
+	for ( j = 0; j < batched->len; )
+	{
+		const float *color = XY_BrushColor( (brush_t *)g_ptr_array_index( batched, j ) );
+		int numVerts = 0;
+		unsigned int k;
+
+		for ( k = j; k < batched->len && XY_BrushColor( (brush_t *)g_ptr_array_index( batched, k ) ) == color; k++ )
+			numVerts += XY_FindBrushCache( (brush_t *)g_ptr_array_index( batched, k ) )->numVerts[m_nViewType];
+		if ( numVerts > batchSize ) {
+			batchSize = numVerts * 2;
+			batch = (float *)realloc( batch, batchSize * 3 * sizeof( float ) );
+		}
+
+		numVerts = 0;
+		for ( ; j < k; j++ )
+		{
+			xyBrushCache_t *cache = XY_FindBrushCache( (brush_t *)g_ptr_array_index( batched, j ) );
+			memcpy( batch + numVerts * 3, cache->lines[m_nViewType], cache->numVerts[m_nViewType] * 3 * sizeof( float ) );
+			numVerts += cache->numVerts[m_nViewType];
+		}
+
+		if ( numVerts ) {
+			qglColor3fv( color );
+			qglVertexPointer( 3, GL_FLOAT, 0, batch );
+			qglDrawArrays( GL_LINES, 0, numVerts );
+		}
+	}
+
 	if ( m_bTiming ) {
 		end2 = Sys_DoubleTime();
 	}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# compares two .bsp files byte for byte, except for the marker lump (lump 0), which
+# carries the compile time. both files must have been written by the same q3map2
+# usage: ./bspcmp.sh <a.bsp> <b.bsp>
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 <a.bsp> <b.bsp>"
+	exit 2
+fi
+
+# lump 0 is the first entry of the lump directory, after the ident and version
+lump0() {
+	od -An -tu4 -j"$2" -N4 "$1" | tr -d ' '
+}
+
+A_OFS=$(lump0 "$1" 8)
+A_LEN=$(lump0 "$1" 12)
+B_OFS=$(lump0 "$2" 8)
+B_LEN=$(lump0 "$2" 12)
+
+if [ -z "$A_OFS" ] || [ "$A_OFS" != "$B_OFS" ] || [ "$A_LEN" != "$B_LEN" ]; then
+	echo "$1 and $2 have different headers"
+	exit 1
+fi
+
+# everything before the marker (header, lump directory) and everything after it
+cmp -n "$A_OFS" "$1" "$2" || exit 1
+cmp -i $(( A_OFS + A_LEN )) "$1" "$2" || exit 1
+exit 0
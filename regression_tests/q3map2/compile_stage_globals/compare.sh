@@ -0,0 +1,48 @@
+#!/bin/sh
+# compiles the test map as three separate q3map2 runs and as one -compile run,
+# then compares the two .bsp files (except the timestamped marker lump)
+# usage: ./compare.sh <q3map2> [general options]
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <q3map2> [general options]"
+	exit 2
+fi
+
+Q3MAP2="$1"
+shift
+
+BSPOPTS="-samplesize 8 -debugsurfaces -custinfoparms -meta"
+VISOPTS="-fast"
+LIGHTOPTS="-fast"
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir -p "$WORK/separate" "$WORK/compile"
+cp -R "$HERE/maps" "$HERE/textures" "$WORK/separate/"
+cp -R "$HERE/maps" "$HERE/textures" "$WORK/compile/"
+
+SEPARATE="$WORK/separate/maps/compile_stage_globals.map"
+COMPILE="$WORK/compile/maps/compile_stage_globals.map"
+
+"$Q3MAP2" "$@" -bsp $BSPOPTS "$SEPARATE" > "$WORK/separate.log" 2>&1 &&
+"$Q3MAP2" "$@" -vis $VISOPTS "$SEPARATE" >> "$WORK/separate.log" 2>&1 &&
+"$Q3MAP2" "$@" -light $LIGHTOPTS "$SEPARATE" >> "$WORK/separate.log" 2>&1 || {
+	cat "$WORK/separate.log"
+	echo "FAILED: separate runs did not complete"
+	exit 1
+}
+
+"$Q3MAP2" "$@" -compile $BSPOPTS -vis $VISOPTS -light $LIGHTOPTS "$COMPILE" > "$WORK/compile.log" 2>&1 || {
+	cat "$WORK/compile.log"
+	echo "FAILED: -compile run did not complete"
+	exit 1
+}
+
+if "$HERE/../bspcmp.sh" "$WORK/separate/maps/compile_stage_globals.bsp" "$WORK/compile/maps/compile_stage_globals.bsp"; then
+	echo "PASSED: -compile output is identical to separate runs"
+	exit 0
+fi
+echo "FAILED: -compile output differs from separate runs"
+exit 1
@@ -0,0 +1,45 @@
+#!/bin/sh
+# lights the test map with -dirty and with -dirty -superspill, then compares the
+# two .bsp files
+# usage: ./compare.sh <q3map2> [general options]
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <q3map2> [general options]"
+	exit 2
+fi
+
+Q3MAP2="$1"
+shift
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir -p "$WORK/resident"
+cp -R "$HERE/maps" "$HERE/textures" "$WORK/resident/"
+
+"$Q3MAP2" "$@" -bsp -meta "$WORK/resident/maps/superspill_dirt.map" > "$WORK/bsp.log" 2>&1 &&
+"$Q3MAP2" "$@" -vis -fast "$WORK/resident/maps/superspill_dirt.map" >> "$WORK/bsp.log" 2>&1 || {
+	cat "$WORK/bsp.log"
+	echo "FAILED: bsp or vis did not complete"
+	exit 1
+}
+cp -R "$WORK/resident" "$WORK/spilled"
+
+"$Q3MAP2" "$@" -light -fast -dirty "$WORK/resident/maps/superspill_dirt.map" > "$WORK/resident.log" 2>&1 || {
+	cat "$WORK/resident.log"
+	echo "FAILED: -dirty light did not complete"
+	exit 1
+}
+"$Q3MAP2" "$@" -light -fast -dirty -superspill "$WORK/spilled/maps/superspill_dirt.map" > "$WORK/spilled.log" 2>&1 || {
+	cat "$WORK/spilled.log"
+	echo "FAILED: -dirty -superspill light did not complete"
+	exit 1
+}
+
+if "$HERE/../bspcmp.sh" "$WORK/resident/maps/superspill_dirt.bsp" "$WORK/spilled/maps/superspill_dirt.bsp"; then
+	echo "PASSED: -superspill output is identical"
+	exit 0
+fi
+echo "FAILED: -superspill output differs"
+exit 1
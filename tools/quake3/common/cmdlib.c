@@ -41,6 +41,7 @@
 
 #if defined ( __linux__ ) || defined ( __APPLE__ )
 #include <unistd.h>
+#include <sys/time.h>
 #endif
 
 #ifdef NeXT
@@ -289,6 +290,33 @@ double I_FloatTime( void ){
 #endif
 }
 
+/*
+   ================
+   I_PreciseTime
+
+   sub-second wall clock time, for profiling
+   ================
+ */
+double I_PreciseTime( void ){
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if ( frequency.QuadPart == 0 ) {
+		QueryPerformanceFrequency( &frequency );
+	}
+	QueryPerformanceCounter( &counter );
+
+	return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+	struct timeval tp;
+
+	gettimeofday( &tp, NULL );
+
+	return tp.tv_sec + tp.tv_usec / 1000000.0;
+#endif
+}
+
 void Q_getwd( char *out ){
 	int i = 0;
 
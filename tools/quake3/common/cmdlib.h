@@ -92,6 +92,7 @@ void ExpandWildcards( int *argc, char ***argv );
 
 
 double I_FloatTime( void );
+double I_PreciseTime( void );
 
 void    Error( const char *error, ... );
 int     CheckParm( const char *check );
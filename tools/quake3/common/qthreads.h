@@ -20,7 +20,12 @@
  */
 
 
+#define MAX_THREADS 64
+
 extern int numthreads;
+extern double threadBusyTime;
+extern double threadWallTime;
+extern double threadBusyTimes[ MAX_THREADS ];
 
 void ThreadSetDefault( void );
 int GetThreadWork( void );
@@ -28,3 +33,5 @@ void RunThreadsOnIndividual( int workcnt, qboolean showpacifier, void ( *func )(
 void RunThreadsOn( int workcnt, qboolean showpacifier, void ( *func )( int ) );
 void ThreadLock( void );
 void ThreadUnlock( void );
+void *ThreadStartBackground( void ( *func )( void * ), void *data );
+void ThreadWaitBackground( void *thread );
@@ -295,6 +295,164 @@ skipspace:
 }
 
 
+/*
+   ==============
+   ParseFastFloat
+
+   Parses a plain decimal number in [start, end) without copying it.
+   Only numbers whose significand and power of ten are both exactly
+   representable in a double are handled, so the result is identical to
+   atof; anything else returns qfalse and must go through atof.
+   ==============
+ */
+#define MAX_FAST_FLOAT_MANTISSA     ( (unsigned long long) 1 << 53 )
+#define MAX_FAST_FLOAT_EXPONENT     22
+
+static const double fastFloatPowers[ MAX_FAST_FLOAT_EXPONENT + 1 ] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static qboolean ParseFastFloat( const char *start, const char *end, double *value ){
+	const char  *p;
+	unsigned long long mantissa;
+	int exponent, expValue, digits;
+	qboolean negative, expNegative;
+
+
+	p = start;
+	mantissa = 0;
+	exponent = 0;
+	digits = 0;
+
+	/* sign */
+	negative = qfalse;
+	if ( p < end && ( *p == '-' || *p == '+' ) ) {
+		negative = ( *p == '-' );
+		p++;
+	}
+
+	/* integer part */
+	while ( p < end && *p >= '0' && *p <= '9' )
+	{
+		mantissa = mantissa * 10 + ( *p - '0' );
+		if ( mantissa > MAX_FAST_FLOAT_MANTISSA ) {
+			return qfalse;
+		}
+		p++;
+		digits++;
+	}
+
+	/* fraction */
+	if ( p < end && *p == '.' ) {
+		p++;
+		while ( p < end && *p >= '0' && *p <= '9' )
+		{
+			mantissa = mantissa * 10 + ( *p - '0' );
+			if ( mantissa > MAX_FAST_FLOAT_MANTISSA ) {
+				return qfalse;
+			}
+			exponent--;
+			p++;
+			digits++;
+		}
+	}
+
+	if ( digits == 0 ) {
+		return qfalse;
+	}
+
+	/* exponent */
+	if ( p < end && ( *p == 'e' || *p == 'E' ) ) {
+		p++;
+		expNegative = qfalse;
+		if ( p < end && ( *p == '-' || *p == '+' ) ) {
+			expNegative = ( *p == '-' );
+			p++;
+		}
+		if ( p >= end ) {
+			return qfalse;
+		}
+		expValue = 0;
+		while ( p < end && *p >= '0' && *p <= '9' )
+		{
+			expValue = expValue * 10 + ( *p - '0' );
+			if ( expValue > 1000 ) {
+				return qfalse;
+			}
+			p++;
+		}
+		exponent += expNegative ? -expValue : expValue;
+	}
+
+	/* must have consumed the whole token */
+	if ( p != end ) {
+		return qfalse;
+	}
+
+	/* both operands are exact, so a single multiply/divide rounds correctly */
+	if ( exponent < -MAX_FAST_FLOAT_EXPONENT || exponent > MAX_FAST_FLOAT_EXPONENT ) {
+		return qfalse;
+	}
+	*value = (double) mantissa;
+	if ( exponent < 0 ) {
+		*value /= fastFloatPowers[ -exponent ];
+	}
+	else{
+		*value *= fastFloatPowers[ exponent ];
+	}
+	if ( negative ) {
+		*value = -*value;
+	}
+
+	return qtrue;
+}
+
+
+/*
+   ==============
+   GetFloatToken
+
+   Equivalent to GetToken followed by atof( token ), but plain numbers on
+   the current line are parsed in place without being copied into token.
+   Note that token is not updated when the fast path is taken, so the
+   result must not be UnGetToken'd.
+   ==============
+ */
+qboolean GetFloatToken( qboolean crossline, vec_t *value ){
+	char        *p, *start;
+	double v;
+
+
+	/* only handle the simple case here: no pending token, no line break, no comment or quote */
+	if ( script != NULL && script->buffer != NULL && script->script_p != NULL && !tokenready ) {
+		p = script->script_p;
+		while ( p < script->end_p && ( *p == ' ' || *p == '\t' || *p == '\r' ) )
+			p++;
+
+		if ( p < script->end_p && ( ( *p >= '0' && *p <= '9' ) || *p == '-' || *p == '+' || *p == '.' ) ) {
+			start = p;
+			while ( p < script->end_p && *p > 32 && *p != ';' )
+				p++;
+
+			if ( ParseFastFloat( start, p, &v ) ) {
+				script->script_p = p;
+				*value = v;
+				return qtrue;
+			}
+		}
+	}
+
+	/* fall back to the generic tokenizer */
+	if ( !GetToken( crossline ) ) {
+		return qfalse;
+	}
+	*value = atof( token );
+	return qtrue;
+}
+
+
 /*
    ==============
    TokenAvailable
@@ -346,8 +504,7 @@ void Parse1DMatrix( int x, vec_t *m ) {
 	MatchToken( "(" );
 
 	for ( i = 0 ; i < x ; i++ ) {
-		GetToken( qfalse );
-		m[i] = atof( token );
+		GetFloatToken( qfalse, &m[i] );
 	}
 
 	MatchToken( ")" );
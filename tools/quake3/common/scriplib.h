@@ -41,6 +41,7 @@ void LoadScriptFile( const char *filename, int index );
 void ParseFromMemory( char *buffer, int size );
 
 qboolean GetToken( qboolean crossline );
+qboolean GetFloatToken( qboolean crossline, vec_t *value );
 void UnGetToken( void );
 qboolean TokenAvailable( void );
 
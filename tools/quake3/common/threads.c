@@ -31,8 +31,6 @@
 #include "inout.h"
 #include "qthreads.h"
 
-#define MAX_THREADS 64
-
 int dispatch;
 int workcount;
 int oldf;
@@ -40,6 +38,12 @@ qboolean pacifier;
 
 qboolean threaded;
 
+/* total time threads spent working vs. available thread time in RunThreadsOnIndividual */
+double threadBusyTime;
+double threadWallTime;
+double threadBusyTimes[ MAX_THREADS ];          /* the same busy time, per thread */
+static double threadBusy[ MAX_THREADS ];
+
 /*
    =============
    GetThreadWork
@@ -78,7 +82,9 @@ void ( *workfunction )( int );
 
 void ThreadWorkerFunction( int threadnum ){
 	int work;
+	double start;
 
+	start = I_PreciseTime();
 	while ( 1 )
 	{
 		work = GetThreadWork();
@@ -88,14 +94,35 @@ void ThreadWorkerFunction( int threadnum ){
 //Sys_Printf ("thread %i, work %i\n", threadnum, work);
 		workfunction( work );
 	}
+
+	/* a thread is busy until it runs out of work */
+	if ( threadnum >= 0 && threadnum < MAX_THREADS ) {
+		threadBusy[ threadnum ] = I_PreciseTime() - start;
+	}
 }
 
 void RunThreadsOnIndividual( int workcnt, qboolean showpacifier, void ( *func )( int ) ){
+	int i, count;
+	double start, wall;
+
 	if ( numthreads == -1 ) {
 		ThreadSetDefault();
 	}
 	workfunction = func;
+
+	memset( threadBusy, 0, sizeof( threadBusy ) );
+	start = I_PreciseTime();
 	RunThreadsOn( workcnt, showpacifier, ThreadWorkerFunction );
+	wall = I_PreciseTime() - start;
+
+	/* accumulate thread utilisation */
+	count = numthreads < MAX_THREADS ? numthreads : MAX_THREADS;
+	for ( i = 0; i < count; i++ )
+	{
+		threadBusyTime += threadBusy[ i ];
+		threadBusyTimes[ i ] += threadBusy[ i ];
+	}
+	threadWallTime += wall * count;
 }
 
 
@@ -208,6 +235,33 @@ void RunThreadsOn( int workcnt, qboolean showpacifier, void ( *func )( int ) ){
 	}
 }
 
+/*
+   =============
+   ThreadStartBackground
+
+   starts a single thread running func( data ) alongside the main thread
+   =============
+ */
+void *ThreadStartBackground( void ( *func )( void * ), void *data ){
+	DWORD threadid;
+	HANDLE thread;
+
+	thread = CreateThread( NULL, ( 4096 * 1024 ), (LPTHREAD_START_ROUTINE)func, (LPVOID)data, 0, &threadid );
+	if ( thread == NULL ) {
+		/* run it here instead */
+		func( data );
+	}
+	return (void*) thread;
+}
+
+void ThreadWaitBackground( void *thread ){
+	if ( thread == NULL ) {
+		return;
+	}
+	WaitForSingleObject( (HANDLE)thread, INFINITE );
+	CloseHandle( (HANDLE)thread );
+}
+
 
 #endif
 
@@ -570,6 +624,38 @@ void RunThreadsOn( int workcnt, qboolean showpacifier, void ( *func )( int ) ){
 		Sys_Printf( " (%i)\n", end - start );
 	}
 }
+
+/*
+   =============
+   ThreadStartBackground
+
+   starts a single thread running func( data ) alongside the main thread
+   =============
+ */
+void *ThreadStartBackground( void ( *func )( void * ), void *data ){
+	pthread_t *thread;
+
+	thread = safe_malloc( sizeof( *thread ) );
+	if ( pthread_create( thread, NULL, (void*)func, data ) != 0 ) {
+		/* run it here instead */
+		free( thread );
+		func( data );
+		return NULL;
+	}
+	return thread;
+}
+
+void ThreadWaitBackground( void *thread ){
+	void *exit_value;
+
+	if ( thread == NULL ) {
+		return;
+	}
+	if ( pthread_join( *( (pthread_t*) thread ), &exit_value ) != 0 ) {
+		Error( "pthread_join failed" );
+	}
+	free( thread );
+}
 #endif // ifdef __linux__
 
 
@@ -617,3 +703,24 @@ void RunThreadsOn( int workcnt, qboolean showpacifier, void ( *func )( int ) ){
 }
 
 #endif
+
+
+/*
+   =======================================================================
+
+   BACKGROUND THREADS (no thread support)
+
+   =======================================================================
+ */
+
+#if !defined( WIN32 ) && !defined( __linux__ )
+
+void *ThreadStartBackground( void ( *func )( void * ), void *data ){
+	func( data );
+	return NULL;
+}
+
+void ThreadWaitBackground( void *thread ){
+}
+
+#endif
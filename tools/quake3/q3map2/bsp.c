@@ -660,6 +660,7 @@ int BSPMain( int argc, char **argv ){
 
 	/* note it */
 	Sys_Printf( "--- BSP ---\n" );
+	TimingBegin( "BSP" );
 
 	SetDrawSurfacesBuffer();
 	mapDrawSurfs = safe_malloc( sizeof( mapDrawSurface_t ) * MAX_MAP_DRAW_SURFS );
@@ -883,19 +884,24 @@ int BSPMain( int argc, char **argv ){
 	/* if onlyents, just grab the entites and resave */
 	if ( onlyents ) {
 		OnlyEnts();
+		TimingEnd();
 		return 0;
 	}
 
 	/* load shaders */
+	TimingBegin( "LoadShaderInfo" );
 	LoadShaderInfo();
+	TimingEnd();
 
 	/* load original file from temp spot in case it was renamed by the editor on the way in */
+	TimingBegin( "LoadMapFile" );
 	if ( strlen( tempSource ) > 0 ) {
 		LoadMapFile( tempSource, qfalse );
 	}
 	else{
 		LoadMapFile( name, qfalse );
 	}
+	TimingEnd();
 
 	/* ydnar: decal setup */
 	ProcessDecals();
@@ -904,7 +910,9 @@ int BSPMain( int argc, char **argv ){
 	SetCloneModelNumbers();
 
 	/* process world and submodels */
+	TimingBegin( "ProcessModels" );
 	ProcessModels();
+	TimingEnd();
 
 	/* set light styles from targetted light entities */
 	SetLightStyles();
@@ -913,13 +921,17 @@ int BSPMain( int argc, char **argv ){
 	ProcessAdvertisements();
 
 	/* finish and write bsp */
+	TimingBegin( "EndBSPFile" );
 	EndBSPFile();
+	TimingEnd();
 
 	/* remove temp map source file if appropriate */
 	if ( strlen( tempSource ) > 0 ) {
 		remove( tempSource );
 	}
 
+	TimingEnd();
+
 	/* return to sender */
 	return 0;
 }
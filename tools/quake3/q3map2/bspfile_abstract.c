@@ -36,6 +36,12 @@
 /* dependencies */
 #include "q3map2.h"
 
+#ifdef Q_UNIX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+#endif
+
 
 
 
@@ -331,22 +337,138 @@ int CopyLump( bspHeader_t *header, int lump, void *dest, int size ){
 
 
 
+/*
+   LoadBSPFileBuffer()
+   maps a bsp file into memory, falling back to reading it where mapping isn't available.
+   the mapping is private, so the loaders may byte swap the header in place.
+   returns the length of the file, and whether it was mapped in *mapped
+ */
+
+int LoadBSPFileBuffer( const char *filename, void **buffer, qboolean *mapped ){
+#ifdef Q_UNIX
+	int fd;
+	struct stat st;
+	void            *map;
+
+
+	/* try to map the file */
+	fd = open( filename, O_RDONLY );
+	if ( fd != -1 ) {
+		if ( fstat( fd, &st ) == 0 && st.st_size > 0 ) {
+			map = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+			if ( map != MAP_FAILED ) {
+				close( fd );
+				*buffer = map;
+				*mapped = qtrue;
+				return (int) st.st_size;
+			}
+		}
+		close( fd );
+	}
+#endif
+
+	/* read it */
+	*mapped = qfalse;
+	return LoadFile( filename, buffer );
+}
+
+
+
+/*
+   FreeBSPFileBuffer()
+   releases a buffer returned by LoadBSPFileBuffer(), with the length and mapped
+   flag it returned
+ */
+
+void FreeBSPFileBuffer( void *buffer, int length, qboolean mapped ){
+#ifdef Q_UNIX
+	if ( mapped ) {
+		munmap( buffer, length );
+		return;
+	}
+#endif
+	free( buffer );
+}
+
+
+
 /*
    AddLump()
-   adds a lump to an outgoing bsp file
+   adds a lump to an outgoing bsp file. the data is written on a background
+   thread while the caller prepares the next lump, so it must stay untouched
+   until the next AddLump() or FlushLumpWrites() call. write errors are reported
+   by FlushLumpWrites() on the main thread, as Error() must not run on the writer
  */
 
-void AddLump( FILE *file, bspHeader_t *header, int lumpNum, const void *data, int length ){
+typedef struct lumpWrite_s
+{
+	FILE                *file;
+	const void          *data;
+	int length;
+	void                *owned;
+	qboolean failed;
+}
+lumpWrite_t;
+
+static lumpWrite_t lumpWrite;
+static void *lumpWriteThread = NULL;
+
+static void WriteLumpThread( void *data ){
+	lumpWrite_t *w = (lumpWrite_t*) data;
+	int count;
+
+
+	count = ( w->length + 3 ) & ~3;
+	w->failed = ( fwrite( w->data, 1, count, w->file ) != (size_t) count );
+	if ( w->owned != NULL ) {
+		free( w->owned );
+	}
+}
+
+void FlushLumpWrites( void ){
+	ThreadWaitBackground( lumpWriteThread );
+	lumpWriteThread = NULL;
+
+	/* report the writer's failure here, after the join */
+	if ( lumpWrite.failed ) {
+		lumpWrite.failed = qfalse;
+		Error( "File write failure" );
+	}
+}
+
+static void AddLumpInternal( FILE *file, bspHeader_t *header, int lumpNum, const void *data, int length, void *owned ){
 	bspLump_t   *lump;
 
 
+	/* lumps go out in order, so wait for the previous one */
+	FlushLumpWrites();
+
 	/* add lump to bsp file header */
 	lump = &header->lumps[ lumpNum ];
 	lump->offset = LittleLong( ftell( file ) );
 	lump->length = LittleLong( length );
 
 	/* write lump to file */
-	SafeWrite( file, data, ( length + 3 ) & ~3 );
+	lumpWrite.file = file;
+	lumpWrite.data = data;
+	lumpWrite.length = length;
+	lumpWrite.owned = owned;
+	lumpWriteThread = ThreadStartBackground( WriteLumpThread, &lumpWrite );
+}
+
+void AddLump( FILE *file, bspHeader_t *header, int lumpNum, const void *data, int length ){
+	AddLumpInternal( file, header, lumpNum, data, length, NULL );
+}
+
+
+
+/*
+   AddLumpBuffer()
+   like AddLump(), but takes ownership of an allocated buffer and frees it once written
+ */
+
+void AddLumpBuffer( FILE *file, bspHeader_t *header, int lumpNum, void *data, int length ){
+	AddLumpInternal( file, header, lumpNum, data, length, data );
 }
 
 
@@ -135,10 +135,7 @@ static void AddBrushSidesLump( FILE *file, ibspHeader_t *header ){
 	}
 
 	/* write lump */
-	AddLump( file, (bspHeader_t*) header, LUMP_BRUSHSIDES, buffer, size );
-
-	/* free buffer */
-	free( buffer );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_BRUSHSIDES, buffer, size );
 }
 
 
@@ -267,10 +264,7 @@ static void AddDrawSurfacesLump( FILE *file, ibspHeader_t *header ){
 	}
 
 	/* write lump */
-	AddLump( file, (bspHeader_t*) header, LUMP_SURFACES, buffer, size );
-
-	/* free buffer */
-	free( buffer );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_SURFACES, buffer, size );
 }
 
 
@@ -357,10 +351,7 @@ static void AddDrawVertsLump( FILE *file, ibspHeader_t *header ){
 	}
 
 	/* write lump */
-	AddLump( file, (bspHeader_t*) header, LUMP_DRAWVERTS, buffer, size );
-
-	/* free buffer */
-	free( buffer );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_DRAWVERTS, buffer, size );
 }
 
 
@@ -441,10 +432,7 @@ static void AddLightGridLumps( FILE *file, ibspHeader_t *header ){
 	}
 
 	/* write lumps */
-	AddLump( file, (bspHeader_t*) header, LUMP_LIGHTGRID, buffer, ( numBSPGridPoints * sizeof( *out ) ) );
-
-	/* free buffer (ydnar 2002-10-22: [bug 641] thanks Rap70r! */
-	free( buffer );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_LIGHTGRID, buffer, ( numBSPGridPoints * sizeof( *out ) ) );
 }
 
 /*
@@ -454,10 +442,12 @@ static void AddLightGridLumps( FILE *file, ibspHeader_t *header ){
 
 void LoadIBSPFile( const char *filename ){
 	ibspHeader_t    *header;
+	int size;
+	qboolean mapped;
 
 
 	/* load the file header */
-	LoadFile( filename, (void**) &header );
+	size = LoadBSPFileBuffer( filename, (void**) &header, &mapped );
 
 	/* swap the header (except the first 4 bytes) */
 	SwapBlock( (int*) ( (byte*) header + sizeof( int ) ), sizeof( *header ) - sizeof( int ) );
@@ -516,7 +506,7 @@ void LoadIBSPFile( const char *filename ){
 	}
 
 	/* free the file buffer */
-	free( header );
+	FreeBSPFileBuffer( header, size, mapped );
 }
 
 
@@ -575,6 +565,9 @@ void WriteIBSPFile( const char *filename ){
 	/* advertisements */
 	AddLump( file, (bspHeader_t*) header, LUMP_ADVERTISEMENTS, bspAds, numBSPAds * sizeof( bspAdvertisement_t ) );
 
+	/* finish writing lumps */
+	FlushLumpWrites();
+
 	/* emit bsp size */
 	size = ftell( file );
 	Sys_Printf( "Wrote %.1f MB (%d bytes)\n", (float) size / ( 1024 * 1024 ), size );
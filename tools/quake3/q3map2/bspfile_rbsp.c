@@ -196,12 +196,8 @@ static void AddLightGridLumps( FILE *file, rbspHeader_t *header ){
 		gridArray[ i ] = LittleShort( gridArray[ i ] );
 
 	/* write lumps */
-	AddLump( file, (bspHeader_t*) header, LUMP_LIGHTGRID, gridPoints, ( numGridPoints * sizeof( *gridPoints ) ) );
-	AddLump( file, (bspHeader_t*) header, LUMP_LIGHTARRAY, gridArray, ( numGridArray * sizeof( *gridArray ) ) );
-
-	/* free buffers */
-	free( gridPoints );
-	free( gridArray );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_LIGHTGRID, gridPoints, ( numGridPoints * sizeof( *gridPoints ) ) );
+	AddLumpBuffer( file, (bspHeader_t*) header, LUMP_LIGHTARRAY, gridArray, ( numGridArray * sizeof( *gridArray ) ) );
 }
 
 
@@ -213,10 +209,12 @@ static void AddLightGridLumps( FILE *file, rbspHeader_t *header ){
 
 void LoadRBSPFile( const char *filename ){
 	rbspHeader_t    *header;
+	int size;
+	qboolean mapped;
 
 
 	/* load the file header */
-	LoadFile( filename, (void**) &header );
+	size = LoadBSPFileBuffer( filename, (void**) &header, &mapped );
 
 	/* swap the header (except the first 4 bytes) */
 	SwapBlock( (int*) ( (byte*) header + sizeof( int ) ), sizeof( *header ) - sizeof( int ) );
@@ -271,7 +269,7 @@ void LoadRBSPFile( const char *filename ){
 	CopyLightGridLumps( header );
 
 	/* free the file buffer */
-	free( header );
+	FreeBSPFileBuffer( header, size, mapped );
 }
 
 
@@ -327,6 +325,9 @@ void WriteRBSPFile( const char *filename ){
 	AddLump( file, (bspHeader_t*) header, LUMP_FOGS, bspFogs, numBSPFogs * sizeof( bspFog_t ) );
 	AddLump( file, (bspHeader_t*) header, LUMP_DRAWINDEXES, bspDrawIndexes, numBSPDrawIndexes * sizeof( bspDrawIndexes[ 0 ] ) );
 
+	/* finish writing lumps */
+	FlushLumpWrites();
+
 	/* emit bsp size */
 	size = ftell( file );
 	Sys_Printf( "Wrote %.1f MB (%d bytes)\n", (float) size / ( 1024 * 1024 ), size );
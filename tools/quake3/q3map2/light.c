@@ -818,8 +818,8 @@ int LightContributionToSample( trace_t *trace ){
 			return 0;
 		}
 
-		/* ptpff approximation */
-		if ( faster ) {
+		/* ptpff approximation (bounce clusters have no winding) */
+		if ( faster || light->w == NULL ) {
 			/* angle attenuation */
 			angle = DotProduct( trace->normal, trace->direction );
 
@@ -1619,14 +1619,16 @@ void LightWorld( void ){
 	vec3_t color;
 	float f;
 	int b, bt;
-	qboolean minVertex, minGrid;
+	qboolean minVertex, minGrid, checkpoint;
 	const char  *value;
 
 
 	/* ydnar: smooth normals */
 	if ( shade ) {
 		Sys_Printf( "--- SmoothNormals ---\n" );
+		TimingBegin( "SmoothNormals" );
 		SmoothNormals();
+		TimingEnd();
 	}
 
 	/* determine the number of grid points */
@@ -1679,8 +1681,10 @@ void LightWorld( void ){
 
 	/* create world lights */
 	Sys_FPrintf( SYS_VRB, "--- CreateLights ---\n" );
+	TimingBegin( "CreateLights" );
 	CreateEntityLights();
 	CreateSurfaceLights();
+	TimingEnd();
 	Sys_Printf( "%9d point lights\n", numPointLights );
 	Sys_Printf( "%9d spotlights\n", numSpotLights );
 	Sys_Printf( "%9d diffuse (area) lights\n", numDiffuseLights );
@@ -1692,7 +1696,9 @@ void LightWorld( void ){
 		SetupEnvelopes( qtrue, fastgrid );
 
 		Sys_Printf( "--- TraceGrid ---\n" );
+		TimingBegin( "TraceGrid" );
 		RunThreadsOnIndividual( numRawGridPoints, qtrue, TraceGrid );
+		TimingEnd();
 		Sys_Printf( "%d x %d x %d = %d grid\n",
 					gridBounds[ 0 ], gridBounds[ 1 ], gridBounds[ 2 ], numBSPGridPoints );
 
@@ -1706,7 +1712,9 @@ void LightWorld( void ){
 
 	/* map the world luxels */
 	Sys_Printf( "--- MapRawLightmap ---\n" );
+	TimingBegin( "MapRawLightmap" );
 	RunThreadsOnIndividual( numRawLightmaps, qtrue, MapRawLightmap );
+	TimingEnd();
 	Sys_Printf( "%9d luxels\n", numLuxels );
 	Sys_Printf( "%9d luxels mapped\n", numLuxelsMapped );
 	Sys_Printf( "%9d luxels occluded\n", numLuxelsOccluded );
@@ -1718,7 +1726,9 @@ void LightWorld( void ){
 
 
 
+		TimingBegin( "DirtyRawLightmap" );
 		RunThreadsOnIndividual( numRawLightmaps, qtrue, DirtyRawLightmap );
+		TimingEnd();
 	}
 
 
@@ -1732,13 +1742,22 @@ void LightWorld( void ){
 	lightsClusterCulled = 0;
 
 	Sys_Printf( "--- IlluminateRawLightmap ---\n" );
+	TimingBegin( "IlluminateRawLightmap" );
 	RunThreadsOnIndividual( numRawLightmaps, qtrue, IlluminateRawLightmap );
+	TimingEnd();
 	Sys_Printf( "%9d luxels illuminated\n", numLuxelsIlluminated );
+	if ( lightCoherence > 1 ) {
+		Sys_Printf( "%9d luxels shadow coherent\n", numLuxelsCoherent );
+	}
 
+	TimingBegin( "StitchSurfaceLightmaps" );
 	StitchSurfaceLightmaps();
+	TimingEnd();
 
 	Sys_Printf( "--- IlluminateVertexes ---\n" );
+	TimingBegin( "IlluminateVertexes" );
 	RunThreadsOnIndividual( numBSPDrawSurfaces, qtrue, IlluminateVertexes );
+	TimingEnd();
 	Sys_Printf( "%9d vertexes illuminated\n", numVertsIlluminated );
 
 	/* ydnar: emit statistics on light culling */
@@ -1752,36 +1771,54 @@ void LightWorld( void ){
 	bt = bounce;
 	while ( bounce > 0 )
 	{
-		/* store off the bsp between bounces */
-		StoreSurfaceLightmaps();
-		Sys_Printf( "Writing %s\n", source );
-		WriteBSPFile( source );
+		/* store off the lightmaps between bounces (kept in memory, the bsp is written once at the end) */
+		checkpoint = ( bounceCheckpoint > 0 && ( ( b - 1 ) % bounceCheckpoint ) == 0 );
+		TimingBegin( "StoreSurfaceLightmaps" );
+		StoreSurfaceLightmaps( checkpoint );
+		TimingEnd();
+
+		/* optionally write a checkpoint bsp */
+		if ( checkpoint ) {
+			Sys_Printf( "Writing %s\n", source );
+			TimingBegin( "WriteBSPFile" );
+			WriteBSPFile( source );
+			TimingEnd();
+		}
 
 		/* note it */
 		Sys_Printf( "\n--- Radiosity (bounce %d of %d) ---\n", b, bt );
+		TimingBegin( "Radiosity" );
 
 		/* flag bouncing */
 		bouncing = qtrue;
 		VectorClear( ambientColor );
 
 		/* generate diffuse lights */
+		TimingBegin( "RadCreateDiffuseLights" );
 		RadFreeLights();
 		RadCreateDiffuseLights();
+		TimingEnd();
 
 		/* setup light envelopes */
 		SetupEnvelopes( qfalse, fastbounce );
 		if ( numLights == 0 ) {
 			Sys_Printf( "No diffuse light to calculate, ending radiosity.\n" );
+			TimingEnd();
 			break;
 		}
 
+		/* cluster the diffuse lights */
+		RadClusterDiffuseLights();
+
 		/* add to lightgrid */
 		if ( bouncegrid ) {
 			gridEnvelopeCulled = 0;
 			gridBoundsCulled = 0;
 
 			Sys_Printf( "--- BounceGrid ---\n" );
+			TimingBegin( "BounceGrid" );
 			RunThreadsOnIndividual( numRawGridPoints, qtrue, TraceGrid );
+			TimingEnd();
 			Sys_FPrintf( SYS_VRB, "%9d grid points envelope culled\n", gridEnvelopeCulled );
 			Sys_FPrintf( SYS_VRB, "%9d grid points bounds culled\n", gridBoundsCulled );
 		}
@@ -1793,14 +1830,20 @@ void LightWorld( void ){
 		lightsClusterCulled = 0;
 
 		Sys_Printf( "--- IlluminateRawLightmap ---\n" );
+		TimingBegin( "IlluminateRawLightmap" );
 		RunThreadsOnIndividual( numRawLightmaps, qtrue, IlluminateRawLightmap );
+		TimingEnd();
 		Sys_Printf( "%9d luxels illuminated\n", numLuxelsIlluminated );
 		Sys_Printf( "%9d vertexes illuminated\n", numVertsIlluminated );
 
+		TimingBegin( "StitchSurfaceLightmaps" );
 		StitchSurfaceLightmaps();
+		TimingEnd();
 
 		Sys_Printf( "--- IlluminateVertexes ---\n" );
+		TimingBegin( "IlluminateVertexes" );
 		RunThreadsOnIndividual( numBSPDrawSurfaces, qtrue, IlluminateVertexes );
+		TimingEnd();
 		Sys_Printf( "%9d vertexes illuminated\n", numVertsIlluminated );
 
 		/* ydnar: emit statistics on light culling */
@@ -1809,6 +1852,8 @@ void LightWorld( void ){
 		Sys_FPrintf( SYS_VRB, "%9d lights bounds culled\n", lightsBoundsCulled );
 		Sys_FPrintf( SYS_VRB, "%9d lights cluster culled\n", lightsClusterCulled );
 
+		TimingEnd();
+
 		/* interate */
 		bounce--;
 		b++;
@@ -1831,6 +1876,7 @@ int LightMain( int argc, char **argv ){
 
 	/* note it */
 	Sys_Printf( "--- Light ---\n" );
+	TimingBegin( "Light" );
 
 	/* set standard game flags */
 	wolfLight = game->wolfLight;
@@ -1920,6 +1966,16 @@ int LightMain( int argc, char **argv ){
 			i++;
 		}
 
+		else if ( !strcmp( argv[ i ], "-tracecache" ) ) {
+			traceCache = qtrue;
+			Sys_Printf( "Reusing the light trace tree between runs on the same geometry\n" );
+		}
+
+		else if ( !strcmp( argv[ i ], "-superspill" ) ) {
+			superSpill = qtrue;
+			Sys_Printf( "Paging raw lightmap origins and normals out to a scratch file\n" );
+		}
+
 		else if ( !strcmp( argv[ i ], "-samples" ) ) {
 			lightSamples = atoi( argv[ i + 1 ] );
 			if ( lightSamples < 1 ) {
@@ -1931,6 +1987,15 @@ int LightMain( int argc, char **argv ){
 			i++;
 		}
 
+		else if ( !strcmp( argv[ i ], "-samplesthreshold" ) ) {
+			lightSamplesThreshold = atof( argv[ i + 1 ] );
+			if ( lightSamplesThreshold < 0.0f ) {
+				lightSamplesThreshold = 0.0f;
+			}
+			Sys_Printf( "Adaptive supersampling of texels differing by more than %.1f\n", lightSamplesThreshold );
+			i++;
+		}
+
 		else if ( !strcmp( argv[ i ], "-filter" ) ) {
 			filter = qtrue;
 			Sys_Printf( "Lightmap filtering enabled\n" );
@@ -2054,6 +2119,37 @@ int LightMain( int argc, char **argv ){
 			}
 		}
 
+		else if ( !strcmp( argv[ i ], "-bouncecheckpoint" ) ) {
+			bounceCheckpoint = atoi( argv[ i + 1 ] );
+			if ( bounceCheckpoint < 0 ) {
+				bounceCheckpoint = 0;
+			}
+			if ( bounceCheckpoint > 0 ) {
+				Sys_Printf( "Writing a checkpoint BSP every %d bounce(s)\n", bounceCheckpoint );
+			}
+			i++;
+		}
+
+		else if ( !strcmp( argv[ i ], "-bouncecluster" ) ) {
+			bounceClusterSize = atof( argv[ i + 1 ] );
+			if ( bounceClusterSize < 0.0f ) {
+				bounceClusterSize = 0.0f;
+			}
+			if ( bounceClusterSize > 0.0f ) {
+				Sys_Printf( "Clustering bounce lights in %.0f unit cells\n", bounceClusterSize );
+			}
+			i++;
+		}
+
+		else if ( !strcmp( argv[ i ], "-bounceclusterratio" ) ) {
+			bounceClusterRatio = atof( argv[ i + 1 ] );
+			if ( bounceClusterRatio < 0.0f ) {
+				bounceClusterRatio = 0.0f;
+			}
+			Sys_Printf( "Bounce clusters used beyond %.1f times their radius\n", bounceClusterRatio > 0.0f ? 1.0f / bounceClusterRatio : 0.0f );
+			i++;
+		}
+
 		else if ( !strcmp( argv[ i ], "-smooth" ) ) {
 			lightSamples = EXTRA_SCALE;
 			Sys_Printf( "The -smooth argument is deprecated, use \"-samples 2\" instead\n" );
@@ -2079,6 +2175,18 @@ int LightMain( int argc, char **argv ){
 			Sys_Printf( "Fast grid lighting enabled\n" );
 		}
 
+		else if ( !strcmp( argv[ i ], "-coherence" ) ) {
+			lightCoherence = atoi( argv[ i + 1 ] );
+			if ( lightCoherence < 2 ) {
+				lightCoherence = 0;
+				Sys_Printf( "Shadow coherence disabled\n" );
+			}
+			else{
+				Sys_Printf( "Shadow coherence enabled, tracing every %d luxel(s) first\n", lightCoherence );
+			}
+			i++;
+		}
+
 		else if ( !strcmp( argv[ i ], "-fastbounce" ) ) {
 			fastbounce = qtrue;
 			Sys_Printf( "Fast bounce mode enabled\n" );
@@ -2273,10 +2381,12 @@ int LightMain( int argc, char **argv ){
 	Sys_Printf( "Loading %s\n", source );
 
 	/* ydnar: load surface file */
+	TimingBegin( "LoadBSPFile" );
 	LoadSurfaceExtraFile( source );
 
 	/* load bsp file */
 	LoadBSPFile( source );
+	TimingEnd();
 
 	/* parse bsp entities */
 	ParseEntities();
@@ -2291,29 +2401,42 @@ int LightMain( int argc, char **argv ){
 	SetEntityOrigins();
 
 	/* ydnar: set up optimization */
+	TimingBegin( "SetupSurfaceLightmaps" );
 	SetupBrushes();
 	SetupDirt();
 	SetupSurfaceLightmaps();
+	TimingEnd();
 
 	/* initialize the surface facet tracing */
+	TimingBegin( "SetupTraceNodes" );
 	SetupTraceNodes();
+	TimingEnd();
 
 	/* light the world */
 	LightWorld();
 
 	/* ydnar: store off lightmaps */
-	StoreSurfaceLightmaps();
+	TimingBegin( "StoreSurfaceLightmaps" );
+	StoreSurfaceLightmaps( qtrue );
+	TimingEnd();
+
+	/* done with the -superspill scratch file */
+	CloseSuperSpill();
 
 	/* write out the bsp */
 	UnparseEntities();
 	Sys_Printf( "Writing %s\n", source );
+	TimingBegin( "WriteBSPFile" );
 	WriteBSPFile( source );
+	TimingEnd();
 
 	/* ydnar: export lightmaps */
 	if ( exportLightmaps && !externalLightmaps ) {
 		ExportLightmaps();
 	}
 
+	TimingEnd();
+
 	/* return to sender */
 	return 0;
 }
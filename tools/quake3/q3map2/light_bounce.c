@@ -46,6 +46,7 @@
  */
 
 void RadFreeLights( void ){
+	int i;
 	light_t     *light, *next;
 
 
@@ -60,6 +61,15 @@ void RadFreeLights( void ){
 	}
 	numLights = 0;
 	lights = NULL;
+
+	/* delete light clusters */
+	for ( i = 0; i < numBounceClusters; i++ )
+		free( bounceClusters[ i ] );
+	if ( bounceClusters != NULL ) {
+		free( bounceClusters );
+	}
+	numBounceClusters = 0;
+	bounceClusters = NULL;
 }
 
 
@@ -883,6 +893,187 @@ void RadLight( int num ){
 
 
 
+/*
+   RadClusterDiffuseLights()
+   groups nearby diffuse lights that share a pvs cluster, style and facing into
+   bounce clusters. a cluster stands in for all of its members when lighting
+   surfaces far enough away (see CreateTraceLightsForBounds), which keeps the
+   number of lights evaluated per luxel down on high bounce counts
+ */
+
+typedef struct radClusterKey_s
+{
+	int cell[ 3 ];
+	int axis, cluster, style, flags;
+	light_t     *light;
+}
+radClusterKey_t;
+
+static int CompareRadClusterKey( const void *a, const void *b ){
+	const radClusterKey_t   *ka, *kb;
+	int i;
+
+
+	ka = (const radClusterKey_t*) a;
+	kb = (const radClusterKey_t*) b;
+	for ( i = 0; i < 3; i++ )
+	{
+		if ( ka->cell[ i ] != kb->cell[ i ] ) {
+			return ka->cell[ i ] < kb->cell[ i ] ? -1 : 1;
+		}
+	}
+	if ( ka->axis != kb->axis ) {
+		return ka->axis < kb->axis ? -1 : 1;
+	}
+	if ( ka->cluster != kb->cluster ) {
+		return ka->cluster < kb->cluster ? -1 : 1;
+	}
+	if ( ka->style != kb->style ) {
+		return ka->style < kb->style ? -1 : 1;
+	}
+	if ( ka->flags != kb->flags ) {
+		return ka->flags < kb->flags ? -1 : 1;
+	}
+	return 0;
+}
+
+void RadClusterDiffuseLights( void ){
+	int i, j, k, numKeys, numClustered;
+	float photons, scale, dist;
+	vec3_t dir;
+	light_t             *light, *cl;
+	radClusterKey_t     *keys, *key;
+
+
+	/* clear out the previous bounce */
+	for ( light = lights; light; light = light->next )
+		light->bounceCluster = NULL;
+	for ( i = 0; i < numBounceClusters; i++ )
+		free( bounceClusters[ i ] );
+	if ( bounceClusters != NULL ) {
+		free( bounceClusters );
+	}
+	numBounceClusters = 0;
+	bounceClusters = NULL;
+
+	/* opt-in */
+	if ( bounceClusterSize <= 0.0f || numLights <= 0 ) {
+		return;
+	}
+
+	/* note it */
+	Sys_FPrintf( SYS_VRB, "--- RadClusterDiffuseLights ---\n" );
+
+	/* key each area light by grid cell, facing axis, pvs cluster, style and flags */
+	keys = safe_malloc( numLights * sizeof( *keys ) );
+	numKeys = 0;
+	for ( light = lights; light && numKeys < numLights; light = light->next )
+	{
+		if ( light->type != EMIT_AREA || light->w == NULL || light->cluster < 0 || light->envelope <= 0.0f ) {
+			continue;
+		}
+
+		key = &keys[ numKeys++ ];
+		for ( i = 0; i < 3; i++ )
+			key->cell[ i ] = (int) floor( light->origin[ i ] / bounceClusterSize );
+		key->axis = 0;
+		for ( i = 1; i < 3; i++ )
+		{
+			if ( fabs( light->normal[ i ] ) > fabs( light->normal[ key->axis ] ) ) {
+				key->axis = i;
+			}
+		}
+		key->axis = ( key->axis << 1 ) | ( light->normal[ key->axis ] < 0.0f ? 1 : 0 );
+		key->cluster = light->cluster;
+		key->style = light->style;
+		key->flags = light->flags;
+		key->light = light;
+	}
+
+	/* sort so that lights belonging together are adjacent */
+	qsort( keys, numKeys, sizeof( *keys ), CompareRadClusterKey );
+
+	/* create a cluster light for each run of 2 or more lights */
+	bounceClusters = safe_malloc( ( numKeys / 2 + 1 ) * sizeof( *bounceClusters ) );
+	numClustered = 0;
+	for ( i = 0; i < numKeys; i = j )
+	{
+		j = i + 1;
+		while ( j < numKeys && CompareRadClusterKey( &keys[ i ], &keys[ j ] ) == 0 )
+			j++;
+		if ( j - i < 2 ) {
+			continue;
+		}
+
+		/* allocate the cluster light (it has no winding, so it is always lit with the ptpff approximation) */
+		cl = safe_malloc( sizeof( *cl ) );
+		memset( cl, 0, sizeof( *cl ) );
+		cl->type = EMIT_AREA;
+		cl->flags = keys[ i ].flags;
+		cl->si = keys[ i ].light->si;
+		cl->style = keys[ i ].style;
+		cl->cluster = keys[ i ].cluster;
+		cl->fade = 1.0f;
+		cl->falloffTolerance = keys[ i ].light->falloffTolerance;
+		cl->filterRadius = keys[ i ].light->filterRadius;
+		cl->bounceClusterNum = numBounceClusters;
+		ClearBounds( cl->mins, cl->maxs );
+
+		/* photon-weighted origin, normal and color */
+		photons = 0.0f;
+		for ( k = i; k < j; k++ )
+		{
+			light = keys[ k ].light;
+			photons += light->photons;
+			VectorMA( cl->origin, light->photons, light->origin, cl->origin );
+			VectorMA( cl->normal, light->photons, light->normal, cl->normal );
+			VectorMA( cl->color, light->photons, light->color, cl->color );
+			AddPointToBounds( light->mins, cl->mins, cl->maxs );
+			AddPointToBounds( light->maxs, cl->mins, cl->maxs );
+		}
+		if ( photons <= 0.0f || VectorNormalize( cl->normal, cl->normal ) == 0.0f ) {
+			free( cl );
+			continue;
+		}
+		VectorScale( cl->origin, 1.0f / photons, cl->origin );
+		VectorScale( cl->color, 1.0f / photons, cl->color );
+		cl->dist = DotProduct( cl->origin, cl->normal );
+
+		/* the far field of the exact form factor is add * area / pi per unit solid angle, and add * area == photons * formFactorValueScale */
+		scale = faster ? 1.0f : formFactorValueScale / Q_PI;
+		cl->photons = photons * scale;
+
+		/* envelope covers every member's envelope */
+		for ( k = i; k < j; k++ )
+		{
+			light = keys[ k ].light;
+			VectorSubtract( light->origin, cl->origin, dir );
+			dist = VectorLength( dir );
+			if ( dist > cl->bounceClusterRadius ) {
+				cl->bounceClusterRadius = dist;
+			}
+			if ( dist + light->envelope > cl->envelope ) {
+				cl->envelope = dist + light->envelope;
+			}
+			light->bounceCluster = cl;
+		}
+		cl->envelope2 = cl->envelope * cl->envelope;
+
+		/* store it */
+		bounceClusters[ numBounceClusters++ ] = cl;
+		numClustered += j - i;
+	}
+
+	/* free keys */
+	free( keys );
+
+	/* emit some statistics */
+	Sys_Printf( "%9d light clusters\n", numBounceClusters );
+	Sys_FPrintf( SYS_VRB, "%9d clustered lights\n", numClustered );
+}
+
+
+
 /*
    RadCreateDiffuseLights()
    creates lights for unbounced light on surfaces in the bsp
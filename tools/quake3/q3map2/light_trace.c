@@ -1307,6 +1307,382 @@ static void PopulateTraceNodes( void ){
 
 
 
+/* -------------------------------------------------------------------------------
+
+   trace cache (-tracecache)
+
+   ------------------------------------------------------------------------------- */
+
+#define TRACE_CACHE_MAGIC       "Q3TC"
+#define TRACE_CACHE_VERSION     2
+
+typedef struct traceCacheHeader_s
+{
+	char magic[ 4 ];
+	int version;
+	unsigned long long hash;
+	int numTraceInfos, numTraceTriangles, numTraceNodes, numItems;
+	int headNodeNum, skyboxNodeNum, maxTraceDepth, numTraceLeafNodes;
+}
+traceCacheHeader_t;
+
+typedef struct traceCacheInfo_s
+{
+	char shader[ MAX_QPATH ];
+	int surfaceNum, castShadows;
+}
+traceCacheInfo_t;
+
+static const char *traceCacheKeys[] =
+{
+	"origin", "modelscale", "modelscale_vec", "angle", "angles",
+	"model", "_frame", "model2", "_frame2", NULL
+};
+
+
+
+/*
+   HashTraceBytes()
+   folds a block of memory into a 64 bit fnv-1a hash
+ */
+
+static void HashTraceBytes( unsigned long long *hash, const void *data, int size ){
+	const byte      *b;
+
+
+	for ( b = (const byte*) data; size > 0; size--, b++ )
+	{
+		*hash ^= *b;
+		*hash *= 1099511628211ULL;
+	}
+}
+
+
+
+/*
+   HashTraceModelFile()
+   folds an external model file's contents into the hash
+ */
+
+static void HashTraceModelFile( unsigned long long *hash, const char *name ){
+	byte            *buffer;
+	int size;
+
+
+	/* bsp models are already covered by the bsp */
+	if ( name[ 0 ] == '\0' || name[ 0 ] == '*' ) {
+		return;
+	}
+
+	/* missing files hash as empty */
+	size = vfsLoadFile( name, (void**) &buffer, 0 );
+	HashTraceBytes( hash, &size, sizeof( size ) );
+	if ( size > 0 ) {
+		HashTraceBytes( hash, buffer, size );
+		free( buffer );
+	}
+}
+
+
+
+/*
+   TraceCacheHash()
+   hashes everything SetupTraceNodes() reads: the bsp tree, shadow casting surfaces,
+   the shader flags, entity model placement and external model files
+ */
+
+static unsigned long long TraceCacheHash( void ){
+	int i, j, castShadows;
+	unsigned long long hash;
+	bspDrawSurface_t    *ds;
+	surfaceInfo_t       *info;
+	bspDrawVert_t       *dv;
+	shaderInfo_t        *si;
+	entity_t            *e;
+	epair_t             *ep;
+	const char          *value;
+
+
+	/* fnv offset basis */
+	hash = 14695981039346656037ULL;
+
+	/* options and struct layout */
+	i = TRACE_CACHE_VERSION;
+	HashTraceBytes( &hash, &i, sizeof( i ) );
+	HashTraceBytes( &hash, &loMem, sizeof( loMem ) );
+	HashTraceBytes( &hash, &patchShadows, sizeof( patchShadows ) );
+	HashTraceBytes( &hash, &noDrawContentFlags, sizeof( noDrawContentFlags ) );
+	HashTraceBytes( &hash, &noDrawSurfaceFlags, sizeof( noDrawSurfaceFlags ) );
+
+	/* bsp tree (light never changes these) */
+	HashTraceBytes( &hash, bspNodes, numBSPNodes * sizeof( *bspNodes ) );
+	HashTraceBytes( &hash, bspPlanes, numBSPPlanes * sizeof( *bspPlanes ) );
+	HashTraceBytes( &hash, bspLeafs, numBSPLeafs * sizeof( *bspLeafs ) );
+	HashTraceBytes( &hash, bspModels, numBSPModels * sizeof( *bspModels ) );
+	HashTraceBytes( &hash, bspDrawIndexes, numBSPDrawIndexes * sizeof( *bspDrawIndexes ) );
+
+	/* vertex positions and texture coordinates (not the lighting written back into them) */
+	for ( i = 0; i < numBSPDrawVerts; i++ )
+	{
+		dv = &bspDrawVerts[ i ];
+		HashTraceBytes( &hash, dv->xyz, sizeof( dv->xyz ) );
+		HashTraceBytes( &hash, dv->st, sizeof( dv->st ) );
+	}
+
+	/* surfaces, minus their lightmap assignment */
+	for ( i = 0; i < numBSPDrawSurfaces; i++ )
+	{
+		ds = &bspDrawSurfaces[ i ];
+		info = &surfaceInfos[ i ];
+		HashTraceBytes( &hash, &ds->surfaceType, sizeof( ds->surfaceType ) );
+		HashTraceBytes( &hash, &ds->firstVert, sizeof( ds->firstVert ) );
+		HashTraceBytes( &hash, &ds->numVerts, sizeof( ds->numVerts ) );
+		HashTraceBytes( &hash, &ds->firstIndex, sizeof( ds->firstIndex ) );
+		HashTraceBytes( &hash, &ds->numIndexes, sizeof( ds->numIndexes ) );
+		HashTraceBytes( &hash, &ds->patchWidth, sizeof( ds->patchWidth ) );
+		HashTraceBytes( &hash, &ds->patchHeight, sizeof( ds->patchHeight ) );
+		HashTraceBytes( &hash, &bspShaders[ ds->shaderNum ].contentFlags, sizeof( int ) );
+		HashTraceBytes( &hash, &bspShaders[ ds->shaderNum ].surfaceFlags, sizeof( int ) );
+		HashTraceBytes( &hash, &info->castShadows, sizeof( info->castShadows ) );
+		HashTraceBytes( &hash, &info->parentSurfaceNum, sizeof( info->parentSurfaceNum ) );
+		HashTraceBytes( &hash, &info->patchIterations, sizeof( info->patchIterations ) );
+		if ( info->si != NULL ) {
+			HashTraceBytes( &hash, info->si->shader, strlen( info->si->shader ) + 1 );
+			HashTraceBytes( &hash, &info->si->compileFlags, sizeof( info->si->compileFlags ) );
+		}
+	}
+
+	/* resolved shader flags: model surfaces look their shaders up by name while the
+	   tree is built, so any shader script edit has to invalidate the cache */
+	HashTraceBytes( &hash, &numShaderInfo, sizeof( numShaderInfo ) );
+	for ( i = 0; i < numShaderInfo; i++ )
+	{
+		si = &shaderInfo[ i ];
+		HashTraceBytes( &hash, si->shader, strlen( si->shader ) + 1 );
+		HashTraceBytes( &hash, &si->compileFlags, sizeof( si->compileFlags ) );
+		HashTraceBytes( &hash, &si->surfaceFlags, sizeof( si->surfaceFlags ) );
+		HashTraceBytes( &hash, &si->contentFlags, sizeof( si->contentFlags ) );
+	}
+
+	/* shadow casting entities */
+	for ( i = 1; i < numEntities; i++ )
+	{
+		e = &entities[ i ];
+		castShadows = ENTITY_CAST_SHADOWS;
+		GetEntityShadowFlags( e, NULL, &castShadows, NULL );
+		HashTraceBytes( &hash, &castShadows, sizeof( castShadows ) );
+		if ( !castShadows ) {
+			continue;
+		}
+		for ( j = 0; traceCacheKeys[ j ] != NULL; j++ )
+		{
+			value = ValueForKey( e, traceCacheKeys[ j ] );
+			HashTraceBytes( &hash, value, strlen( value ) + 1 );
+		}
+		for ( ep = e->epairs; ep != NULL; ep = ep->next )
+		{
+			if ( !Q_strncasecmp( ep->key, "_remap", 6 ) ) {
+				HashTraceBytes( &hash, ep->key, strlen( ep->key ) + 1 );
+				HashTraceBytes( &hash, ep->value, strlen( ep->value ) + 1 );
+			}
+		}
+		HashTraceModelFile( &hash, ValueForKey( e, "model" ) );
+		HashTraceModelFile( &hash, ValueForKey( e, "model2" ) );
+	}
+
+	/* return it */
+	return hash;
+}
+
+
+
+/*
+   LoadTraceCache()
+   loads the raytracing tree from the -tracecache file if it matches the hash
+ */
+
+static qboolean LoadTraceCache( const char *filename, unsigned long long hash ){
+	int i, numItems;
+	FILE                *file;
+	traceCacheHeader_t header;
+	traceCacheInfo_t ci;
+	traceNode_t         *node;
+	qboolean ok;
+
+
+	/* open the file */
+	file = fopen( filename, "rb" );
+	if ( file == NULL ) {
+		return qfalse;
+	}
+
+	/* check the header */
+	if ( fread( &header, sizeof( header ), 1, file ) != 1 ||
+		 memcmp( header.magic, TRACE_CACHE_MAGIC, 4 ) ||
+		 header.version != TRACE_CACHE_VERSION ||
+		 header.hash != hash ) {
+		fclose( file );
+		return qfalse;
+	}
+
+	/* allocate */
+	maxTraceInfos = numTraceInfos = header.numTraceInfos;
+	maxTraceTriangles = numTraceTriangles = header.numTraceTriangles;
+	maxTraceNodes = numTraceNodes = header.numTraceNodes;
+	traceInfos = safe_malloc( ( numTraceInfos + 1 ) * sizeof( *traceInfos ) );
+	traceTriangles = safe_malloc( ( numTraceTriangles + 1 ) * sizeof( *traceTriangles ) );
+	traceNodes = safe_malloc( ( numTraceNodes + 1 ) * sizeof( *traceNodes ) );
+	ok = qtrue;
+
+	/* read trace infos, shaders are stored by name */
+	for ( i = 0; i < numTraceInfos && ok; i++ )
+	{
+		ok = ( fread( &ci, sizeof( ci ), 1, file ) == 1 );
+		ci.shader[ MAX_QPATH - 1 ] = '\0';
+		traceInfos[ i ].si = ( ok && ci.shader[ 0 ] != '\0' ) ? ShaderInfoForShader( ci.shader ) : NULL;
+		traceInfos[ i ].surfaceNum = ci.surfaceNum;
+		traceInfos[ i ].castShadows = ci.castShadows;
+	}
+
+	/* read triangles and nodes */
+	if ( ok ) {
+		ok = ( fread( traceTriangles, sizeof( *traceTriangles ), numTraceTriangles, file ) == (size_t) numTraceTriangles &&
+			   fread( traceNodes, sizeof( *traceNodes ), numTraceNodes, file ) == (size_t) numTraceNodes );
+	}
+
+	/* read leaf item lists */
+	numItems = 0;
+	for ( i = 0; i < numTraceNodes; i++ )
+	{
+		node = &traceNodes[ i ];
+		node->items = NULL;
+		if ( !ok || node->type >= 0 || node->numItems <= 0 ) {
+			node->maxItems = 0;
+			continue;
+		}
+		node->maxItems = node->numItems;
+		node->items = safe_malloc( node->numItems * sizeof( *node->items ) );
+		ok = ( fread( node->items, sizeof( *node->items ), node->numItems, file ) == (size_t) node->numItems );
+		numItems += node->numItems;
+	}
+
+	/* close the file */
+	fclose( file );
+
+	/* bad file? */
+	if ( !ok || numItems != header.numItems ) {
+		Sys_Printf( "WARNING: %s is truncated, rebuilding the trace tree\n", filename );
+		for ( i = 0; i < numTraceNodes; i++ )
+		{
+			if ( traceNodes[ i ].items != NULL ) {
+				free( traceNodes[ i ].items );
+			}
+		}
+		free( traceInfos );
+		free( traceTriangles );
+		free( traceNodes );
+		traceInfos = NULL;
+		traceTriangles = NULL;
+		traceNodes = NULL;
+		numTraceInfos = maxTraceInfos = 0;
+		numTraceTriangles = maxTraceTriangles = 0;
+		numTraceNodes = maxTraceNodes = 0;
+		return qfalse;
+	}
+
+	/* set tree globals */
+	headNodeNum = header.headNodeNum;
+	skyboxNodeNum = header.skyboxNodeNum;
+	maxTraceDepth = header.maxTraceDepth;
+	numTraceLeafNodes = header.numTraceLeafNodes;
+	return qtrue;
+}
+
+
+
+/*
+   WriteTraceCache()
+   writes the finished raytracing tree to the -tracecache file
+ */
+
+static void WriteTraceCache( const char *filename, unsigned long long hash ){
+	int i;
+	qboolean ok;
+	FILE                *file;
+	traceCacheHeader_t header;
+	traceCacheInfo_t ci;
+	traceNode_t         *node;
+
+
+	/* open the file */
+	file = fopen( filename, "wb" );
+	if ( file == NULL ) {
+		Sys_Printf( "WARNING: Unable to write trace cache %s\n", filename );
+		return;
+	}
+
+	/* fill out the header */
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, TRACE_CACHE_MAGIC, 4 );
+	header.version = TRACE_CACHE_VERSION;
+	header.hash = hash;
+	header.numTraceInfos = numTraceInfos;
+	header.numTraceTriangles = numTraceTriangles;
+	header.numTraceNodes = numTraceNodes;
+	for ( i = 0; i < numTraceNodes; i++ )
+	{
+		if ( traceNodes[ i ].type < 0 && traceNodes[ i ].numItems > 0 ) {
+			header.numItems += traceNodes[ i ].numItems;
+		}
+	}
+	header.headNodeNum = headNodeNum;
+	header.skyboxNodeNum = skyboxNodeNum;
+	header.maxTraceDepth = maxTraceDepth;
+	header.numTraceLeafNodes = numTraceLeafNodes;
+	ok = ( fwrite( &header, sizeof( header ), 1, file ) == 1 );
+
+	/* write trace infos */
+	for ( i = 0; ok && i < numTraceInfos; i++ )
+	{
+		memset( &ci, 0, sizeof( ci ) );
+		if ( traceInfos[ i ].si != NULL ) {
+			strncpy( ci.shader, traceInfos[ i ].si->shader, MAX_QPATH - 1 );
+		}
+		ci.surfaceNum = traceInfos[ i ].surfaceNum;
+		ci.castShadows = traceInfos[ i ].castShadows;
+		ok = ( fwrite( &ci, sizeof( ci ), 1, file ) == 1 );
+	}
+
+	/* write triangles and nodes */
+	if ( ok ) {
+		ok = ( fwrite( traceTriangles, sizeof( *traceTriangles ), numTraceTriangles, file ) == (size_t) numTraceTriangles &&
+			   fwrite( traceNodes, sizeof( *traceNodes ), numTraceNodes, file ) == (size_t) numTraceNodes );
+	}
+
+	/* write leaf item lists */
+	for ( i = 0; ok && i < numTraceNodes; i++ )
+	{
+		node = &traceNodes[ i ];
+		if ( node->type < 0 && node->numItems > 0 ) {
+			ok = ( fwrite( node->items, sizeof( *node->items ), node->numItems, file ) == (size_t) node->numItems );
+		}
+	}
+
+	/* close the file, a partial cache would only be rejected on the next run so remove it */
+	if ( fclose( file ) != 0 ) {
+		ok = qfalse;
+	}
+	if ( !ok ) {
+		Sys_Printf( "WARNING: Error writing trace cache %s (disk full?)\n", filename );
+		remove( filename );
+		return;
+	}
+	Sys_Printf( "Wrote trace cache %s\n", filename );
+}
+
+
+
+
 /* -------------------------------------------------------------------------------
 
    trace initialization
@@ -1319,6 +1695,10 @@ static void PopulateTraceNodes( void ){
  */
 
 void SetupTraceNodes( void ){
+	char cacheFile[ 1024 ];
+	unsigned long long cacheHash = 0;
+
+
 	/* note it */
 	Sys_FPrintf( SYS_VRB, "--- SetupTraceNodes ---\n" );
 
@@ -1326,6 +1706,20 @@ void SetupTraceNodes( void ){
 	noDrawContentFlags = noDrawSurfaceFlags = noDrawCompileFlags = 0;
 	ApplySurfaceParm( "nodraw", &noDrawContentFlags, &noDrawSurfaceFlags, &noDrawCompileFlags );
 
+	/* reuse the tree from an earlier run on the same geometry */
+	if ( traceCache ) {
+		strcpy( cacheFile, source );
+		StripExtension( cacheFile );
+		strcat( cacheFile, ".tracecache" );
+		cacheHash = TraceCacheHash();
+		if ( LoadTraceCache( cacheFile, cacheHash ) ) {
+			Sys_Printf( "Loaded trace cache %s\n", cacheFile );
+			Sys_FPrintf( SYS_VRB, "%9d trace triangles (%.2fMB)\n", numTraceTriangles, (float) ( numTraceTriangles * sizeof( *traceTriangles ) ) / ( 1024.0f * 1024.0f ) );
+			Sys_FPrintf( SYS_VRB, "%9d trace nodes (%.2fMB)\n", numTraceNodes, (float) ( numTraceNodes * sizeof( *traceNodes ) ) / ( 1024.0f * 1024.0f ) );
+			return;
+		}
+	}
+
 	/* create the baseline raytracing tree from the bsp tree */
 	headNodeNum = SetupTraceNodes_r( 0 );
 
@@ -1361,6 +1755,11 @@ void SetupTraceNodes( void ){
 	maxTraceWindings = 0;
 	deadWinding = -1;
 
+	/* save the tree for the next run */
+	if ( traceCache ) {
+		WriteTraceCache( cacheFile, cacheHash );
+	}
+
 	/* debug code: write out trace triangles to an alias obj file */
 	#if 0
 	{
@@ -1712,17 +2111,149 @@ static qboolean TraceLine_r( int nodeNum, vec3_t origin, vec3_t end, trace_t *tr
 
 
 /*
-   TraceLine() - ydnar
-   rewrote this function a bit :)
+   TracePacket_r()
+   walks the trace tree once for a packet of ray segments. every ray notes the
+   same leaves in the same order as TraceLine_r() would, so results match exactly
  */
 
-void TraceLine( trace_t *trace ){
-	int i, j;
+typedef struct traceRay_s
+{
+	int num;
+	vec3_t start, end;
+}
+traceRay_t;
+
+static void TracePacket_r( int nodeNum, int numRays, traceRay_t *rays, trace_t *traces ){
+	int i, side, numFront, numBack, numAgain;
 	traceNode_t     *node;
-	traceTriangle_t *tt;
-	traceInfo_t     *ti;
+	traceRay_t      *ray;
+	trace_t         *trace;
+	float front, back, frac;
+	vec3_t mid;
+	traceRay_t frontRays[ MAX_TRACE_PACKET ], backRays[ MAX_TRACE_PACKET ], againRays[ MAX_TRACE_PACKET ];
+
+
+	/* bogus node number means solid, end tracing */
+	node = nodeNum >= 0 ? &traceNodes[ nodeNum ] : NULL;
+	if ( node == NULL || node->type == TRACE_LEAF_SOLID ) {
+		for ( i = 0; i < numRays; i++ )
+		{
+			trace = &traces[ rays[ i ].num ];
+			if ( !trace->passSolid ) {
+				VectorCopy( rays[ i ].start, trace->hit );
+				trace->passSolid = qtrue;
+			}
+		}
+		return;
+	}
+
+	/* leafnode? */
+	if ( node->type < 0 ) {
+		for ( i = 0; i < numRays; i++ )
+		{
+			trace = &traces[ rays[ i ].num ];
+			if ( !trace->passSolid && node->numItems > 0 && trace->numTestNodes < MAX_TRACE_TEST_NODES ) {
+				trace->testNodes[ trace->numTestNodes++ ] = nodeNum;
+			}
+		}
+		return;
+	}
+
+	/* split the packet: front first, then back, then the far half of rays that started in back */
+	numFront = numBack = numAgain = 0;
+	for ( i = 0; i < numRays; i++ )
+	{
+		ray = &rays[ i ];
+		trace = &traces[ ray->num ];
+
+		/* finished rays and empty testall branches */
+		if ( trace->passSolid || ( trace->testAll && node->numItems == 0 ) ) {
+			continue;
+		}
+
+		/* classify beginning and end points */
+		switch ( node->type )
+		{
+		case PLANE_X:
+			front = ray->start[ 0 ] - node->plane[ 3 ];
+			back = ray->end[ 0 ] - node->plane[ 3 ];
+			break;
+
+		case PLANE_Y:
+			front = ray->start[ 1 ] - node->plane[ 3 ];
+			back = ray->end[ 1 ] - node->plane[ 3 ];
+			break;
+
+		case PLANE_Z:
+			front = ray->start[ 2 ] - node->plane[ 3 ];
+			back = ray->end[ 2 ] - node->plane[ 3 ];
+			break;
+
+		default:
+			front = DotProduct( ray->start, node->plane ) - node->plane[ 3 ];
+			back = DotProduct( ray->end, node->plane ) - node->plane[ 3 ];
+			break;
+		}
+
+		/* entirely in front side? */
+		if ( front >= -TRACE_ON_EPSILON && back >= -TRACE_ON_EPSILON ) {
+			frontRays[ numFront++ ] = *ray;
+			continue;
+		}
+
+		/* entirely on back side? */
+		if ( front < TRACE_ON_EPSILON && back < TRACE_ON_EPSILON ) {
+			backRays[ numBack++ ] = *ray;
+			continue;
+		}
+
+		/* select side and calculate intercept point */
+		side = front < 0;
+		frac = front / ( front - back );
+		mid[ 0 ] = ray->start[ 0 ] + ( ray->end[ 0 ] - ray->start[ 0 ] ) * frac;
+		mid[ 1 ] = ray->start[ 1 ] + ( ray->end[ 1 ] - ray->start[ 1 ] ) * frac;
+		mid[ 2 ] = ray->start[ 2 ] + ( ray->end[ 2 ] - ray->start[ 2 ] ) * frac;
+
+		/* near half goes with its side, far half follows */
+		if ( side == 0 ) {
+			frontRays[ numFront ] = *ray;
+			VectorCopy( mid, frontRays[ numFront ].end );
+			numFront++;
+			backRays[ numBack ] = *ray;
+			VectorCopy( mid, backRays[ numBack ].start );
+			numBack++;
+		}
+		else
+		{
+			backRays[ numBack ] = *ray;
+			VectorCopy( mid, backRays[ numBack ].end );
+			numBack++;
+			againRays[ numAgain ] = *ray;
+			VectorCopy( mid, againRays[ numAgain ].start );
+			numAgain++;
+		}
+	}
+
+	/* trace the children */
+	if ( numFront > 0 ) {
+		TracePacket_r( node->children[ 0 ], numFront, frontRays, traces );
+	}
+	if ( numBack > 0 ) {
+		TracePacket_r( node->children[ 1 ], numBack, backRays, traces );
+	}
+	if ( numAgain > 0 ) {
+		TracePacket_r( node->children[ 0 ], numAgain, againRays, traces );
+	}
+}
+
 
 
+/*
+   TraceLineBegin()
+   resets trace output, returns qfalse if the trace can be skipped
+ */
+
+static qboolean TraceLineBegin( trace_t *trace ){
 	/* setup output (note: this code assumes the input data is completely filled out) */
 	trace->passSolid = qfalse;
 	trace->opaque = qfalse;
@@ -1731,11 +2262,35 @@ void TraceLine( trace_t *trace ){
 
 	/* early outs */
 	if ( !trace->recvShadows || !trace->testOcclusion || trace->distance <= 0.00001f ) {
-		return;
+		return qfalse;
 	}
 
-	/* trace through nodes */
-	TraceLine_r( headNodeNum, trace->origin, trace->end, trace );
+	/* count it (atomic, every light thread traces) */
+	if ( timings ) {
+#ifdef WIN32
+		InterlockedIncrement( ( volatile LONG * ) &numTraces );
+#else
+		__sync_fetch_and_add( &numTraces, 1 );
+#endif
+	}
+	return qtrue;
+}
+
+
+
+/*
+   TraceLineEnd()
+   tests the triangles in the leaves found by the tree walk
+ */
+
+static void TraceLineEnd( trace_t *trace ){
+	int i, j;
+	traceNode_t     *node;
+	traceTriangle_t *tt;
+	traceInfo_t     *ti;
+
+
+	/* solid */
 	if ( trace->passSolid && !trace->testAll ) {
 		trace->opaque = qtrue;
 		return;
@@ -1776,6 +2331,67 @@ void TraceLine( trace_t *trace ){
 
 
 
+/*
+   TraceLine() - ydnar
+   rewrote this function a bit :)
+ */
+
+void TraceLine( trace_t *trace ){
+	/* setup */
+	if ( !TraceLineBegin( trace ) ) {
+		return;
+	}
+
+	/* trace through nodes */
+	TraceLine_r( headNodeNum, trace->origin, trace->end, trace );
+
+	/* test triangles */
+	TraceLineEnd( trace );
+}
+
+
+
+/*
+   TraceLinePacket()
+   traces up to MAX_TRACE_PACKET set up traces with a single walk of the trace tree.
+   meant for rays sharing an origin (dirt, sky), results are identical to TraceLine()
+ */
+
+void TraceLinePacket( trace_t *traces, int numTraces ){
+	int i, numRays;
+	traceRay_t rays[ MAX_TRACE_PACKET ];
+
+
+	/* dummy check */
+	if ( numTraces > MAX_TRACE_PACKET ) {
+		Error( "TraceLinePacket: %d traces exceeds MAX_TRACE_PACKET (%d)", numTraces, MAX_TRACE_PACKET );
+	}
+
+	/* setup */
+	numRays = 0;
+	for ( i = 0; i < numTraces; i++ )
+	{
+		if ( TraceLineBegin( &traces[ i ] ) ) {
+			rays[ numRays ].num = i;
+			VectorCopy( traces[ i ].origin, rays[ numRays ].start );
+			VectorCopy( traces[ i ].end, rays[ numRays ].end );
+			numRays++;
+		}
+	}
+	if ( numRays == 0 ) {
+		return;
+	}
+
+	/* trace through nodes */
+	TracePacket_r( headNodeNum, numRays, rays, traces );
+
+	/* test triangles */
+	for ( i = 0; i < numRays; i++ )
+		TraceLineEnd( &traces[ rays[ i ].num ] );
+}
+
+
+
 /*
    SetupTrace() - ydnar
    sets up certain trace values
@@ -110,90 +110,70 @@ void ColorToBytes( const float *color, byte *colorBytes, float scale ){
 #define THETA_EPSILON           0.000001
 #define EQUAL_NORMAL_EPSILON    0.01
 
-void SmoothNormals( void ){
-	int i, j, k, f, cs, numVerts, numVotes, fOld, start;
-	float shadeAngle, defaultShadeAngle, maxShadeAngle, dot, testAngle;
-	bspDrawSurface_t    *ds;
-	shaderInfo_t        *si;
-	float               *shadeAngles;
-	byte                *smoothed;
-	vec3_t average, diff;
-	int indexes[ MAX_SAMPLES ];
-	vec3_t votes[ MAX_SAMPLES ];
+/* vertexes are hashed into cells at least EQUAL_EPSILON wide so VectorCompare only needs neighbouring cells */
+#define SMOOTH_CELL_SIZE        1.0f
 
+static float                *smoothShadeAngles;
+static byte                 *smoothFlags;
+static int                  *smoothOrder;
+static int                  *smoothComponentStart;
+static int                  *smoothComponentSize;
 
-	/* allocate shade angle table */
-	shadeAngles = safe_malloc( numBSPDrawVerts * sizeof( float ) );
-	memset( shadeAngles, 0, numBSPDrawVerts * sizeof( float ) );
 
-	/* allocate smoothed table */
-	cs = ( numBSPDrawVerts / 8 ) + 1;
-	smoothed = safe_malloc( cs );
-	memset( smoothed, 0, cs );
 
-	/* set default shade angle */
-	defaultShadeAngle = DEG2RAD( shadeAngleDegrees );
-	maxShadeAngle = 0;
+/*
+   SmoothFindRoot()
+   union-find lookup (with path halving) for groups of coincident vertexes
+ */
 
-	/* run through every surface and flag verts belonging to non-lightmapped surfaces
-	   and set per-vertex smoothing angle */
-	for ( i = 0; i < numBSPDrawSurfaces; i++ )
+static int SmoothFindRoot( int *parents, int i ){
+	while ( parents[ i ] != i )
 	{
-		/* get drawsurf */
-		ds = &bspDrawSurfaces[ i ];
+		parents[ i ] = parents[ parents[ i ] ];
+		i = parents[ i ];
+	}
+	return i;
+}
 
-		/* get shader for shade angle */
-		si = surfaceInfos[ i ].si;
-		if ( si->shadeAngleDegrees ) {
-			shadeAngle = DEG2RAD( si->shadeAngleDegrees );
-		}
-		else{
-			shadeAngle = defaultShadeAngle;
-		}
-		if ( shadeAngle > maxShadeAngle ) {
-			maxShadeAngle = shadeAngle;
-		}
 
-		/* flag its verts */
-		for ( j = 0; j < ds->numVerts; j++ )
-		{
-			f = ds->firstVert + j;
-			shadeAngles[ f ] = shadeAngle;
-			if ( ds->surfaceType == MST_TRIANGLE_SOUP ) {
-				smoothed[ f >> 3 ] |= ( 1 << ( f & 7 ) );
-			}
-		}
 
-		/* ydnar: optional force-to-trisoup */
-		if ( trisoup && ds->surfaceType == MST_PLANAR ) {
-			ds->surfaceType = MST_TRIANGLE_SOUP;
-			ds->lightmapNum[ 0 ] = -3;
-		}
-	}
+/*
+   SmoothCellHash()
+   hashes a vertex cell
+ */
+
+static int SmoothCellHash( int x, int y, int z, int hashMask ){
+	return (int) ( ( (unsigned int) x * 73856093U ) ^ ( (unsigned int) y * 19349663U ) ^ ( (unsigned int) z * 83492791U ) ) & hashMask;
+}
+
+
+
+/*
+   SmoothComponent()
+   smooths one group of vertexes that are within EQUAL_EPSILON of each other (threaded).
+   vertexes in different groups can never be coincident, so this gives the same
+   results as walking every vertex in order
+ */
+
+static void SmoothComponent( int componentNum ){
+	int i, j, k, a, b, count, numVerts, numVotes;
+	int             *members;
+	float shadeAngle, dot, testAngle;
+	vec3_t average, diff;
+	int indexes[ MAX_SAMPLES ];
+	vec3_t votes[ MAX_SAMPLES ];
 
-	/* bail if no surfaces have a shade angle */
-	if ( maxShadeAngle == 0 ) {
-		free( shadeAngles );
-		free( smoothed );
-		return;
-	}
 
-	/* init pacifier */
-	fOld = -1;
-	start = I_FloatTime();
+	/* get the group (sorted by vertex number) */
+	members = &smoothOrder[ smoothComponentStart[ componentNum ] ];
+	count = smoothComponentSize[ componentNum ];
 
 	/* go through the list of vertexes */
-	for ( i = 0; i < numBSPDrawVerts; i++ )
+	for ( a = 0; a < count; a++ )
 	{
-		/* print pacifier */
-		f = 10 * i / numBSPDrawVerts;
-		if ( f != fOld ) {
-			fOld = f;
-			Sys_Printf( "%i...", f );
-		}
-
 		/* already smoothed? */
-		if ( smoothed[ i >> 3 ] & ( 1 << ( i & 7 ) ) ) {
+		i = members[ a ];
+		if ( smoothFlags[ i ] ) {
 			continue;
 		}
 
@@ -203,10 +183,11 @@ void SmoothNormals( void ){
 		numVotes = 0;
 
 		/* build a table of coincident vertexes */
-		for ( j = i; j < numBSPDrawVerts && numVerts < MAX_SAMPLES; j++ )
+		for ( b = a; b < count && numVerts < MAX_SAMPLES; b++ )
 		{
 			/* already smoothed? */
-			if ( smoothed[ j >> 3 ] & ( 1 << ( j & 7 ) ) ) {
+			j = members[ b ];
+			if ( smoothFlags[ j ] ) {
 				continue;
 			}
 
@@ -216,7 +197,7 @@ void SmoothNormals( void ){
 			}
 
 			/* use smallest shade angle */
-			shadeAngle = ( shadeAngles[ i ] < shadeAngles[ j ] ? shadeAngles[ i ] : shadeAngles[ j ] );
+			shadeAngle = ( smoothShadeAngles[ i ] < smoothShadeAngles[ j ] ? smoothShadeAngles[ i ] : smoothShadeAngles[ j ] );
 
 			/* check shade angle */
 			dot = DotProduct( bspDrawVerts[ i ].normal, bspDrawVerts[ j ].normal );
@@ -228,16 +209,14 @@ void SmoothNormals( void ){
 			}
 			testAngle = acos( dot ) + THETA_EPSILON;
 			if ( testAngle >= shadeAngle ) {
-				//Sys_Printf( "F(%3.3f >= %3.3f) ", RAD2DEG( testAngle ), RAD2DEG( shadeAngle ) );
 				continue;
 			}
-			//Sys_Printf( "P(%3.3f < %3.3f) ", RAD2DEG( testAngle ), RAD2DEG( shadeAngle ) );
 
 			/* add to the list */
 			indexes[ numVerts++ ] = j;
 
 			/* flag vertex */
-			smoothed[ j >> 3 ] |= ( 1 << ( j & 7 ) );
+			smoothFlags[ j ] = 1;
 
 			/* see if this normal has already been voted */
 			for ( k = 0; k < numVotes; k++ )
@@ -270,13 +249,170 @@ void SmoothNormals( void ){
 				VectorCopy( average, yDrawVerts[ indexes[ j ] ].normal );
 		}
 	}
+}
 
-	/* free the tables */
-	free( shadeAngles );
-	free( smoothed );
 
-	/* print time */
-	Sys_Printf( " (%i)\n", (int) ( I_FloatTime() - start ) );
+
+void SmoothNormals( void ){
+	int i, j, f, x, y, z, h, hashSize, hashMask, numComponents;
+	int mins[ 3 ], maxs[ 3 ];
+	float shadeAngle, defaultShadeAngle, maxShadeAngle;
+	bspDrawSurface_t    *ds;
+	shaderInfo_t        *si;
+	int                 *hashHeads, *hashNext, *parents, *counts;
+
+
+	/* allocate shade angle table */
+	smoothShadeAngles = safe_malloc( numBSPDrawVerts * sizeof( float ) );
+	memset( smoothShadeAngles, 0, numBSPDrawVerts * sizeof( float ) );
+
+	/* allocate smoothed table */
+	smoothFlags = safe_malloc( numBSPDrawVerts + 1 );
+	memset( smoothFlags, 0, numBSPDrawVerts + 1 );
+
+	/* set default shade angle */
+	defaultShadeAngle = DEG2RAD( shadeAngleDegrees );
+	maxShadeAngle = 0;
+
+	/* run through every surface and flag verts belonging to non-lightmapped surfaces
+	   and set per-vertex smoothing angle */
+	for ( i = 0; i < numBSPDrawSurfaces; i++ )
+	{
+		/* get drawsurf */
+		ds = &bspDrawSurfaces[ i ];
+
+		/* get shader for shade angle */
+		si = surfaceInfos[ i ].si;
+		if ( si->shadeAngleDegrees ) {
+			shadeAngle = DEG2RAD( si->shadeAngleDegrees );
+		}
+		else{
+			shadeAngle = defaultShadeAngle;
+		}
+		if ( shadeAngle > maxShadeAngle ) {
+			maxShadeAngle = shadeAngle;
+		}
+
+		/* flag its verts */
+		for ( j = 0; j < ds->numVerts; j++ )
+		{
+			f = ds->firstVert + j;
+			smoothShadeAngles[ f ] = shadeAngle;
+			if ( ds->surfaceType == MST_TRIANGLE_SOUP ) {
+				smoothFlags[ f ] = 1;
+			}
+		}
+
+		/* ydnar: optional force-to-trisoup */
+		if ( trisoup && ds->surfaceType == MST_PLANAR ) {
+			ds->surfaceType = MST_TRIANGLE_SOUP;
+			ds->lightmapNum[ 0 ] = -3;
+		}
+	}
+
+	/* bail if no surfaces have a shade angle */
+	if ( maxShadeAngle == 0 ) {
+		free( smoothShadeAngles );
+		free( smoothFlags );
+		return;
+	}
+
+	/* allocate spatial hash */
+	for ( hashSize = 1024; hashSize < numBSPDrawVerts; hashSize <<= 1 ) ;
+	hashMask = hashSize - 1;
+	hashHeads = safe_malloc( hashSize * sizeof( int ) );
+	memset( hashHeads, 0xFF, hashSize * sizeof( int ) );
+	hashNext = safe_malloc( ( numBSPDrawVerts + 1 ) * sizeof( int ) );
+	parents = safe_malloc( ( numBSPDrawVerts + 1 ) * sizeof( int ) );
+
+	/* link each vertex to every earlier coincident vertex */
+	for ( i = 0; i < numBSPDrawVerts; i++ )
+	{
+		parents[ i ] = i;
+		hashNext[ i ] = -1;
+
+		/* smoothed vertexes are never touched */
+		if ( smoothFlags[ i ] ) {
+			continue;
+		}
+
+		/* get the cells a coincident vertex could be in */
+		for ( j = 0; j < 3; j++ )
+		{
+			mins[ j ] = (int) floor( ( yDrawVerts[ i ].xyz[ j ] - EQUAL_EPSILON ) / SMOOTH_CELL_SIZE );
+			maxs[ j ] = (int) floor( ( yDrawVerts[ i ].xyz[ j ] + EQUAL_EPSILON ) / SMOOTH_CELL_SIZE );
+		}
+
+		/* union with the vertexes already there */
+		for ( x = mins[ 0 ]; x <= maxs[ 0 ]; x++ )
+		for ( y = mins[ 1 ]; y <= maxs[ 1 ]; y++ )
+		for ( z = mins[ 2 ]; z <= maxs[ 2 ]; z++ )
+		{
+			for ( j = hashHeads[ SmoothCellHash( x, y, z, hashMask ) ]; j >= 0; j = hashNext[ j ] )
+			{
+				if ( VectorCompare( yDrawVerts[ i ].xyz, yDrawVerts[ j ].xyz ) ) {
+					parents[ SmoothFindRoot( parents, i ) ] = SmoothFindRoot( parents, j );
+				}
+			}
+		}
+
+		/* add it to its own cell */
+		h = SmoothCellHash( (int) floor( yDrawVerts[ i ].xyz[ 0 ] / SMOOTH_CELL_SIZE ),
+							(int) floor( yDrawVerts[ i ].xyz[ 1 ] / SMOOTH_CELL_SIZE ),
+							(int) floor( yDrawVerts[ i ].xyz[ 2 ] / SMOOTH_CELL_SIZE ), hashMask );
+		hashNext[ i ] = hashHeads[ h ];
+		hashHeads[ h ] = i;
+	}
+	free( hashHeads );
+
+	/* count group sizes (reusing the chain table) */
+	counts = hashNext;
+	memset( counts, 0, numBSPDrawVerts * sizeof( int ) );
+	for ( i = 0; i < numBSPDrawVerts; i++ )
+	{
+		parents[ i ] = SmoothFindRoot( parents, i );
+		counts[ parents[ i ] ]++;
+	}
+
+	/* only groups of 2 or more vertexes can be smoothed */
+	smoothComponentStart = safe_malloc( ( numBSPDrawVerts / 2 + 1 ) * sizeof( int ) );
+	smoothComponentSize = safe_malloc( ( numBSPDrawVerts / 2 + 1 ) * sizeof( int ) );
+	numComponents = 0;
+	f = 0;
+	for ( i = 0; i < numBSPDrawVerts; i++ )
+	{
+		if ( counts[ i ] >= 2 ) {
+			smoothComponentStart[ numComponents ] = f;
+			smoothComponentSize[ numComponents ] = 0;
+			f += counts[ i ];
+			counts[ i ] = numComponents++;
+		}
+		else{
+			counts[ i ] = -1;
+		}
+	}
+
+	/* sort vertexes by group, keeping vertex order within each group */
+	smoothOrder = safe_malloc( ( f + 1 ) * sizeof( int ) );
+	for ( i = 0; i < numBSPDrawVerts; i++ )
+	{
+		j = counts[ parents[ i ] ];
+		if ( j >= 0 ) {
+			smoothOrder[ smoothComponentStart[ j ] + smoothComponentSize[ j ]++ ] = i;
+		}
+	}
+	free( parents );
+	free( counts );
+
+	/* smooth each group */
+	RunThreadsOnIndividual( numComponents, qtrue, SmoothComponent );
+
+	/* free the tables */
+	free( smoothShadeAngles );
+	free( smoothFlags );
+	free( smoothOrder );
+	free( smoothComponentStart );
+	free( smoothComponentSize );
 }
 
 
@@ -925,6 +1061,9 @@ void MapRawLightmap( int rawLightmapNum ){
 	/* get lightmap */
 	lm = &rawLightmaps[ rawLightmapNum ];
 
+	/* page in origins and normals (-superspill) */
+	UnspillRawLightmap( lm );
+
 	/* -----------------------------------------------------------------
 	   map referenced surfaces onto the raw lightmap
 	   ----------------------------------------------------------------- */
@@ -1115,6 +1254,7 @@ void MapRawLightmap( int rawLightmapNum ){
 
 	/* non-planar surfaces stop here */
 	if ( lm->plane == NULL ) {
+		SpillRawLightmap( lm );
 		return;
 	}
 
@@ -1275,6 +1415,9 @@ void MapRawLightmap( int rawLightmapNum ){
 		}
 	}
 	#endif
+
+	/* page out origins and normals (-superspill) */
+	SpillRawLightmap( lm );
 }
 
 
@@ -1329,9 +1472,10 @@ void SetupDirt( void ){
  */
 
 float DirtForSample( trace_t *trace ){
-	int i;
+	int i, j, numPacket;
 	float gatherDirt, outDirt, angle, elevation, ooDepth;
 	vec3_t normal, worldUp, myUp, myRt, temp, direction, displacement;
+	trace_t traces[ MAX_TRACE_PACKET ];
 
 
 	/* dummy check */
@@ -1367,17 +1511,28 @@ float DirtForSample( trace_t *trace ){
 		VectorNormalize( myUp, myUp );
 	}
 
-	/* 1 = random mode, 0 (well everything else) = non-random mode */
-	if ( dirtMode == 1 ) {
-		/* iterate */
-		for ( i = 0; i < numDirtVectors; i++ )
+	/* trace the dirt vectors in packets sharing the sample origin */
+	for ( i = 0; i < numDirtVectors; i += numPacket )
+	{
+		numPacket = numDirtVectors - i;
+		if ( numPacket > MAX_TRACE_PACKET ) {
+			numPacket = MAX_TRACE_PACKET;
+		}
+
+		for ( j = 0; j < numPacket; j++ )
 		{
-			/* get random vector */
-			angle = Random() * DEG2RAD( 360.0f );
-			elevation = Random() * DEG2RAD( DIRT_CONE_ANGLE );
-			temp[ 0 ] = cos( angle ) * sin( elevation );
-			temp[ 1 ] = sin( angle ) * sin( elevation );
-			temp[ 2 ] = cos( elevation );
+			/* 1 = random mode, 0 (well everything else) = non-random mode */
+			if ( dirtMode == 1 ) {
+				/* get random vector */
+				angle = Random() * DEG2RAD( 360.0f );
+				elevation = Random() * DEG2RAD( DIRT_CONE_ANGLE );
+				temp[ 0 ] = cos( angle ) * sin( elevation );
+				temp[ 1 ] = sin( angle ) * sin( elevation );
+				temp[ 2 ] = cos( elevation );
+			}
+			else{
+				VectorCopy( dirtVectors[ i + j ], temp );
+			}
 
 			/* transform into tangent space */
 			direction[ 0 ] = myRt[ 0 ] * temp[ 0 ] + myUp[ 0 ] * temp[ 1 ] + normal[ 0 ] * temp[ 2 ];
@@ -1385,35 +1540,17 @@ float DirtForSample( trace_t *trace ){
 			direction[ 2 ] = myRt[ 2 ] * temp[ 0 ] + myUp[ 2 ] * temp[ 1 ] + normal[ 2 ] * temp[ 2 ];
 
 			/* set endpoint */
-			VectorMA( trace->origin, dirtDepth, direction, trace->end );
-			SetupTrace( trace );
-
-			/* trace */
-			TraceLine( trace );
-			if ( trace->opaque ) {
-				VectorSubtract( trace->hit, trace->origin, displacement );
-				gatherDirt += 1.0f - ooDepth * VectorLength( displacement );
-			}
+			memcpy( &traces[ j ], trace, sizeof( *trace ) );
+			VectorMA( trace->origin, dirtDepth, direction, traces[ j ].end );
+			SetupTrace( &traces[ j ] );
 		}
-	}
-	else
-	{
-		/* iterate through ordered vectors */
-		for ( i = 0; i < numDirtVectors; i++ )
-		{
-			/* transform vector into tangent space */
-			direction[ 0 ] = myRt[ 0 ] * dirtVectors[ i ][ 0 ] + myUp[ 0 ] * dirtVectors[ i ][ 1 ] + normal[ 0 ] * dirtVectors[ i ][ 2 ];
-			direction[ 1 ] = myRt[ 1 ] * dirtVectors[ i ][ 0 ] + myUp[ 1 ] * dirtVectors[ i ][ 1 ] + normal[ 1 ] * dirtVectors[ i ][ 2 ];
-			direction[ 2 ] = myRt[ 2 ] * dirtVectors[ i ][ 0 ] + myUp[ 2 ] * dirtVectors[ i ][ 1 ] + normal[ 2 ] * dirtVectors[ i ][ 2 ];
 
-			/* set endpoint */
-			VectorMA( trace->origin, dirtDepth, direction, trace->end );
-			SetupTrace( trace );
-
-			/* trace */
-			TraceLine( trace );
-			if ( trace->opaque ) {
-				VectorSubtract( trace->hit, trace->origin, displacement );
+		/* trace */
+		TraceLinePacket( traces, numPacket );
+		for ( j = 0; j < numPacket; j++ )
+		{
+			if ( traces[ j ].opaque ) {
+				VectorSubtract( traces[ j ].hit, traces[ j ].origin, displacement );
 				gatherDirt += 1.0f - ooDepth * VectorLength( displacement );
 			}
 		}
@@ -1474,6 +1611,9 @@ void DirtyRawLightmap( int rawLightmapNum ){
 	/* get lightmap */
 	lm = &rawLightmaps[ rawLightmapNum ];
 
+	/* page in origins and normals (-superspill) */
+	UnspillRawLightmap( lm );
+
 	/* setup trace */
 	trace.testOcclusion = qtrue;
 	trace.forceSunlight = qfalse;
@@ -1580,6 +1720,10 @@ void DirtyRawLightmap( int rawLightmapNum ){
 			*dirt = average / samples;
 		}
 	}
+
+	/* page out origins and normals (-superspill), dirt lives in the normals so write them back */
+	lm->superSpillModified = qtrue;
+	SpillRawLightmap( lm );
 }
 
 
@@ -1668,6 +1812,23 @@ static qboolean SubmapRawLuxel( rawLightmap_t *lm, int x, int y, float bx, float
 }
 
 
+/*
+   SampleContrast()
+   returns qtrue if a stamp of light samples differs by more than -samplesthreshold
+   in any channel (a smooth gradient that adaptive supersampling should refine)
+ */
+
+static qboolean SampleContrast( vec3_t colorMins, vec3_t colorMaxs ){
+	if ( lightSamplesThreshold <= 0.0f ) {
+		return qfalse;
+	}
+	return ( colorMaxs[ 0 ] - colorMins[ 0 ] ) > lightSamplesThreshold ||
+		   ( colorMaxs[ 1 ] - colorMins[ 1 ] ) > lightSamplesThreshold ||
+		   ( colorMaxs[ 2 ] - colorMins[ 2 ] ) > lightSamplesThreshold;
+}
+
+
+
 /*
    SubsampleRawLuxel_r()
    recursively subsamples a luxel until its color gradient is low enough or subsampling limit is reached
@@ -1679,7 +1840,7 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 	vec4_t luxel[ 4 ];
 	vec3_t origin[ 4 ], normal[ 4 ];
 	float biasDirs[ 4 ][ 2 ] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f } };
-	vec3_t color, total;
+	vec3_t color, total, colorMins, colorMaxs;
 
 
 	/* limit check */
@@ -1689,6 +1850,7 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 
 	/* setup */
 	VectorClear( total );
+	ClearBounds( colorMins, colorMaxs );
 	mapped = 0;
 	lighted = 0;
 
@@ -1717,9 +1879,10 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 
 		LightContributionToSample( trace );
 
-		/* add to totals (fixme: make contrast function) */
+		/* add to totals */
 		VectorCopy( trace->color, luxel[ b ] );
 		VectorAdd( total, trace->color, total );
+		AddPointToBounds( trace->color, colorMins, colorMaxs );
 		if ( ( luxel[ b ][ 0 ] + luxel[ b ][ 1 ] + luxel[ b ][ 2 ] ) > 0.0f ) {
 			lighted++;
 		}
@@ -1728,7 +1891,7 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 	/* subsample further? */
 	if ( ( lightLuxel[ 3 ] + 1.0f ) < lightSamples &&
 		 ( total[ 0 ] > 4.0f || total[ 1 ] > 4.0f || total[ 2 ] > 4.0f ) &&
-		 lighted != 0 && lighted != mapped ) {
+		 ( ( lighted != 0 && lighted != mapped ) || SampleContrast( colorMins, colorMaxs ) ) ) {
 		for ( b = 0; b < 4; b++ )
 		{
 			if ( cluster[ b ] < 0 ) {
@@ -1767,6 +1930,39 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 
 
 
+/*
+   CoherentShadow()
+   with -coherence, returns COHERENCE_LIT or COHERENCE_SHADOWED if the four coarse grid
+   luxels around a super luxel agree on the current light, otherwise COHERENCE_NONE
+ */
+
+#define COHERENCE_NONE          0
+#define COHERENCE_LIT           1
+#define COHERENCE_SHADOWED      2
+#define COHERENCE_GRID( v, size )   ( ( ( v ) % lightCoherence ) == 0 || ( v ) == ( ( size ) - 1 ) )
+
+static int CoherentShadow( rawLightmap_t *lm, byte *coherence, int x, int y ){
+	int x0, y0, x1, y1, state;
+
+
+	/* get surrounding grid luxels */
+	x0 = ( x / lightCoherence ) * lightCoherence;
+	y0 = ( y / lightCoherence ) * lightCoherence;
+	x1 = x0 + lightCoherence < lm->sw ? x0 + lightCoherence : lm->sw - 1;
+	y1 = y0 + lightCoherence < lm->sh ? y0 + lightCoherence : lm->sh - 1;
+
+	/* they must all agree */
+	state = coherence[ y0 * lm->sw + x0 ];
+	if ( coherence[ y0 * lm->sw + x1 ] != state ||
+		 coherence[ y1 * lm->sw + x0 ] != state ||
+		 coherence[ y1 * lm->sw + x1 ] != state ) {
+		return COHERENCE_NONE;
+	}
+	return state;
+}
+
+
+
 /*
    IlluminateRawLightmap()
    illuminates the luxels
@@ -1777,14 +1973,16 @@ static void SubsampleRawLuxel_r( rawLightmap_t *lm, trace_t *trace, vec3_t sampl
 
 void IlluminateRawLightmap( int rawLightmapNum ){
 	int i, t, x, y, sx, sy, size, llSize, luxelFilterRadius, lightmapNum;
-	int                 *cluster, *cluster2, mapped, lighted, totalLighted;
+	int                 *cluster, *cluster2, mapped, lighted, totalLighted, pass, state;
+	int coherent;
+	byte                *coherence;
 	rawLightmap_t       *lm;
 	surfaceInfo_t       *info;
 	qboolean filterColor, filterDir;
 	float brightness;
 	float               *origin, *normal, *dirt, *luxel, *luxel2, *deluxel, *deluxel2;
 	float               *lightLuxels, *lightLuxel, samples, filterRadius, weight;
-	vec3_t color, averageColor, averageDir, total, temp, temp2;
+	vec3_t color, averageColor, averageDir, total, temp, temp2, colorMins, colorMaxs;
 	float tests[ 4 ][ 2 ] = { { 0.0f, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
 	trace_t trace;
 	float stackLightLuxels[ STACK_LL_SIZE ];
@@ -1798,6 +1996,12 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 	/* get lightmap */
 	lm = &rawLightmaps[ rawLightmapNum ];
 
+	/* page in origins and normals (-superspill) */
+	UnspillRawLightmap( lm );
+
+	/* coherent luxels are counted locally and added to the total once at the end */
+	coherent = 0;
+
 	/* setup trace */
 	trace.testOcclusion = !noTrace;
 	trace.forceSunlight = qfalse;
@@ -1905,6 +2109,9 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 			lightLuxels = safe_malloc( llSize );
 		}
 
+		/* allocate per-light shadow coherence (-coherence) */
+		coherence = ( lightCoherence > 1 && trace.testOcclusion ) ? safe_malloc( lm->sw * lm->sh ) : NULL;
+
 		/* clear luxels */
 		//%	memset( lm->superLuxels[ 0 ], 0, llSize );
 
@@ -1974,47 +2181,95 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 			memset( lightLuxels, 0, llSize );
 			totalLighted = 0;
 
-			/* initial pass, one sample per luxel */
-			for ( y = 0; y < lm->sh; y++ )
+			/* initial pass, one sample per luxel (-coherence traces a coarse grid of them first) */
+			if ( coherence != NULL ) {
+				memset( coherence, COHERENCE_NONE, lm->sw * lm->sh );
+			}
+			for ( pass = ( coherence != NULL ? 0 : 1 ); pass < 2; pass++ )
 			{
-				for ( x = 0; x < lm->sw; x++ )
+				for ( y = 0; y < lm->sh; y++ )
 				{
-					/* get cluster */
-					cluster = SUPER_CLUSTER( x, y );
-					if ( *cluster < 0 ) {
-						continue;
-					}
+					for ( x = 0; x < lm->sw; x++ )
+					{
+						/* get cluster */
+						cluster = SUPER_CLUSTER( x, y );
+						if ( *cluster < 0 ) {
+							continue;
+						}
 
-					/* get particulars */
-					lightLuxel = LIGHT_LUXEL( x, y );
-					deluxel = SUPER_DELUXEL( x, y );
-					origin = SUPER_ORIGIN( x, y );
-					normal = SUPER_NORMAL( x, y );
+						/* coarse grid luxels in the first pass, the rest in the second */
+						state = COHERENCE_NONE;
+						if ( coherence != NULL ) {
+							if ( ( COHERENCE_GRID( x, lm->sw ) && COHERENCE_GRID( y, lm->sh ) ) != ( pass == 0 ) ) {
+								continue;
+							}
+							if ( pass == 1 ) {
+								state = CoherentShadow( lm, coherence, x, y );
+							}
+						}
 
-					/* set contribution count */
-					lightLuxel[ 3 ] = 1.0f;
+						/* get particulars */
+						lightLuxel = LIGHT_LUXEL( x, y );
+						deluxel = SUPER_DELUXEL( x, y );
+						origin = SUPER_ORIGIN( x, y );
+						normal = SUPER_NORMAL( x, y );
 
-					/* setup trace */
-					trace.cluster = *cluster;
-					VectorCopy( origin, trace.origin );
-					VectorCopy( normal, trace.normal );
+						/* set contribution count */
+						lightLuxel[ 3 ] = 1.0f;
 
-					/* get light for this sample */
-					LightContributionToSample( &trace );
-					VectorCopy( trace.color, lightLuxel );
+						/* the surrounding grid is all in shadow */
+						if ( state == COHERENCE_SHADOWED ) {
+							coherent++;
+							continue;
+						}
 
-					/* add to count */
-					if ( trace.color[ 0 ] || trace.color[ 1 ] || trace.color[ 2 ] ) {
-						totalLighted++;
-					}
+						/* setup trace */
+						trace.cluster = *cluster;
+						VectorCopy( origin, trace.origin );
+						VectorCopy( normal, trace.normal );
+
+						/* get light for this sample */
+						if ( state == COHERENCE_LIT ) {
+							/* the surrounding grid is all unoccluded, skip the shadow ray */
+							trace.testOcclusion = qfalse;
+							LightContributionToSample( &trace );
+							trace.testOcclusion = qtrue;
+							coherent++;
+						}
+						else if ( pass == 0 ) {
+							/* grid luxel, note if it is fully shadowed or fully unoccluded (not filtered) */
+							if ( LightContributionToSample( &trace ) < 0 ) {
+								coherence[ y * lm->sw + x ] = COHERENCE_SHADOWED;
+							}
+							else if ( trace.color[ 0 ] || trace.color[ 1 ] || trace.color[ 2 ] ) {
+								VectorCopy( trace.color, temp );
+								trace.testOcclusion = qfalse;
+								LightContributionToSample( &trace );
+								trace.testOcclusion = qtrue;
+								if ( VectorCompare( temp, trace.color ) ) {
+									coherence[ y * lm->sw + x ] = COHERENCE_LIT;
+								}
+								VectorCopy( temp, trace.color );
+							}
+						}
+						else{
+							LightContributionToSample( &trace );
+						}
+						VectorCopy( trace.color, lightLuxel );
 
-					/* add to light direction map (fixme: use luxel normal as starting point for deluxel?) */
-					if ( deluxemap ) {
-						/* color to grayscale (photoshop rgb weighting) */
-						brightness = trace.color[ 0 ] * 0.3f + trace.color[ 1 ] * 0.59f + trace.color[ 2 ] * 0.11f;
-						brightness *= ( 1.0 / 255.0 );
-						VectorScale( trace.direction, brightness, trace.direction );
-						VectorAdd( deluxel, trace.direction, deluxel );
+						/* add to count */
+						if ( trace.color[ 0 ] || trace.color[ 1 ] || trace.color[ 2 ] ) {
+							totalLighted++;
+						}
+
+						/* add to light direction map (fixme: use luxel normal as starting point for deluxel?) */
+						if ( deluxemap ) {
+							/* color to grayscale (photoshop rgb weighting) */
+							brightness = trace.color[ 0 ] * 0.3f + trace.color[ 1 ] * 0.59f + trace.color[ 2 ] * 0.11f;
+							brightness *= ( 1.0 / 255.0 );
+							VectorScale( trace.direction, brightness, trace.direction );
+							VectorAdd( deluxel, trace.direction, deluxel );
+						}
 					}
 				}
 			}
@@ -2038,7 +2293,7 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 				luxelFilterRadius = 1;
 			}
 
-			/* secondary pass, adaptive supersampling (fixme: use a contrast function to determine if subsampling is necessary) */
+			/* secondary pass, adaptive supersampling of shadow edges and (with -samplesthreshold) high contrast stamps */
 			/* 2003-09-27: changed it so filtering disamples supersampling, as it would waste time */
 			if ( lightSamples > 1 && luxelFilterRadius == 0 ) {
 				/* walk luxels */
@@ -2050,6 +2305,7 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 						mapped = 0;
 						lighted = 0;
 						VectorClear( total );
+						ClearBounds( colorMins, colorMaxs );
 
 						/* test 2x2 stamp */
 						for ( t = 0; t < 4; t++ )
@@ -2068,6 +2324,7 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 							/* get luxel */
 							lightLuxel = LIGHT_LUXEL( sx, sy );
 							VectorAdd( total, lightLuxel, total );
+							AddPointToBounds( lightLuxel, colorMins, colorMaxs );
 							if ( ( lightLuxel[ 0 ] + lightLuxel[ 1 ] + lightLuxel[ 2 ] ) > 0.0f ) {
 								lighted++;
 							}
@@ -2078,8 +2335,8 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 							continue;
 						}
 
-						/* if all 4 pixels are either in shadow or light, then don't subsample */
-						if ( lighted != 0 && lighted != mapped ) {
+						/* if all 4 pixels are either in shadow or light (and close in color), then don't subsample */
+						if ( ( lighted != 0 && lighted != mapped ) || SampleContrast( colorMins, colorMaxs ) ) {
 							for ( t = 0; t < 4; t++ )
 							{
 								/* set sample coords */
@@ -2254,6 +2511,9 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 		if ( lightLuxels != stackLightLuxels ) {
 			free( lightLuxels );
 		}
+		if ( coherence != NULL ) {
+			free( coherence );
+		}
 	}
 
 	/* free light list */
@@ -2403,6 +2663,16 @@ void IlluminateRawLightmap( int rawLightmapNum ){
 			}
 		}
 	}
+
+	/* add this lightmap's coherent luxels to the total */
+	if ( coherent > 0 ) {
+		ThreadLock();
+		numLuxelsCoherent += coherent;
+		ThreadUnlock();
+	}
+
+	/* page out origins and normals (-superspill) */
+	SpillRawLightmap( lm );
 }
 
 
@@ -3166,6 +3436,183 @@ qboolean ChopBounds( vec3_t mins, vec3_t maxs, vec3_t origin, vec3_t normal ){
 
 
 
+/*
+   SetupClusterLights()
+   builds a list of candidate lights for each pvs cluster from the pvs and the
+   light envelopes, so CreateTraceLightsForBounds() only walks visible lights
+ */
+
+#define CLUSTER_LIGHT_EPSILON   16.0f
+
+static int numClusterLightClusters = 0;
+static int                  *clusterLightFirst = NULL;
+static int                  *clusterLightNums = NULL;
+static int numClusterLightSuns = 0;
+static int                  *clusterLightSuns = NULL;
+static light_t              **clusterLightsByNum = NULL;
+
+static void FreeClusterLights( void ){
+	if ( clusterLightFirst != NULL ) {
+		free( clusterLightFirst );
+	}
+	if ( clusterLightNums != NULL ) {
+		free( clusterLightNums );
+	}
+	if ( clusterLightSuns != NULL ) {
+		free( clusterLightSuns );
+	}
+	if ( clusterLightsByNum != NULL ) {
+		free( clusterLightsByNum );
+	}
+	numClusterLightClusters = 0;
+	clusterLightFirst = NULL;
+	clusterLightNums = NULL;
+	numClusterLightSuns = 0;
+	clusterLightSuns = NULL;
+	clusterLightsByNum = NULL;
+}
+
+static void SetupClusterLights( void ){
+	int i, j, c, pass, numClusters, leafBytes, lightNum, total, *fill;
+	light_t     *light;
+	bspLeaf_t   *leaf;
+	byte        *pvs;
+	float d, dist;
+	vec3_t      *clusterMins, *clusterMaxs;
+
+
+	/* clear out the old lists */
+	FreeClusterLights();
+	if ( numLights <= 0 ) {
+		return;
+	}
+
+	/* count clusters */
+	numClusters = 0;
+	for ( i = 0; i < numBSPLeafs; i++ )
+	{
+		if ( bspLeafs[ i ].cluster >= numClusters ) {
+			numClusters = bspLeafs[ i ].cluster + 1;
+		}
+	}
+	if ( numClusters <= 0 ) {
+		return;
+	}
+
+	/* get cluster bounds */
+	clusterMins = safe_malloc( numClusters * sizeof( vec3_t ) );
+	clusterMaxs = safe_malloc( numClusters * sizeof( vec3_t ) );
+	for ( c = 0; c < numClusters; c++ )
+		ClearBounds( clusterMins[ c ], clusterMaxs[ c ] );
+	for ( i = 0; i < numBSPLeafs; i++ )
+	{
+		leaf = &bspLeafs[ i ];
+		if ( leaf->cluster < 0 ) {
+			continue;
+		}
+		for ( j = 0; j < 3; j++ )
+		{
+			if ( leaf->mins[ j ] < clusterMins[ leaf->cluster ][ j ] ) {
+				clusterMins[ leaf->cluster ][ j ] = leaf->mins[ j ];
+			}
+			if ( leaf->maxs[ j ] > clusterMaxs[ leaf->cluster ][ j ] ) {
+				clusterMaxs[ leaf->cluster ][ j ] = leaf->maxs[ j ];
+			}
+		}
+	}
+
+	/* number the lights in list order (which is sorted by style) */
+	clusterLightsByNum = safe_malloc( numLights * sizeof( *clusterLightsByNum ) );
+	clusterLightSuns = safe_malloc( numLights * sizeof( *clusterLightSuns ) );
+	clusterLightFirst = safe_malloc( ( numClusters + 1 ) * sizeof( *clusterLightFirst ) );
+	memset( clusterLightFirst, 0, ( numClusters + 1 ) * sizeof( *clusterLightFirst ) );
+	for ( lightNum = 0, light = lights; light && lightNum < numLights; lightNum++, light = light->next )
+		clusterLightsByNum[ lightNum ] = light;
+	numClusterLightClusters = numClusters;
+
+	/* get pvs row size */
+	leafBytes = numBSPVisBytes > VIS_HEADER_SIZE ? ( (int*) bspVisBytes )[ 1 ] : 0;
+
+	/* first pass counts, second pass fills */
+	total = 0;
+	fill = NULL;
+	for ( pass = 0; pass < 2; pass++ )
+	{
+		for ( lightNum = 0; lightNum < numLights; lightNum++ )
+		{
+			light = clusterLightsByNum[ lightNum ];
+
+			/* sunlight is visible everywhere */
+			if ( light->type == EMIT_SUN ) {
+				if ( pass == 0 ) {
+					clusterLightSuns[ numClusterLightSuns++ ] = lightNum;
+				}
+				continue;
+			}
+			if ( light->cluster < 0 || light->envelope <= 0.0f ) {
+				continue;
+			}
+
+			/* walk the clusters in this light's pvs */
+			pvs = leafBytes > 0 ? bspVisBytes + VIS_HEADER_SIZE + ( light->cluster * leafBytes ) : NULL;
+			for ( c = 0; c < numClusters; c++ )
+			{
+				if ( c != light->cluster && pvs != NULL && !( pvs[ c >> 3 ] & ( 1 << ( c & 7 ) ) ) ) {
+					continue;
+				}
+
+				/* does the envelope reach the cluster bounds? */
+				dist = 0.0f;
+				for ( j = 0; j < 3; j++ )
+				{
+					if ( light->origin[ j ] < clusterMins[ c ][ j ] ) {
+						d = clusterMins[ c ][ j ] - light->origin[ j ];
+					}
+					else if ( light->origin[ j ] > clusterMaxs[ c ][ j ] ) {
+						d = light->origin[ j ] - clusterMaxs[ c ][ j ];
+					}
+					else{
+						d = 0.0f;
+					}
+					dist += d * d;
+				}
+				d = light->envelope + CLUSTER_LIGHT_EPSILON;
+				if ( dist > d * d ) {
+					continue;
+				}
+
+				/* count or store */
+				if ( pass == 0 ) {
+					clusterLightFirst[ c + 1 ]++;
+				}
+				else{
+					clusterLightNums[ fill[ c ]++ ] = lightNum;
+				}
+			}
+		}
+
+		/* turn counts into offsets */
+		if ( pass == 0 ) {
+			for ( c = 0; c < numClusters; c++ )
+				clusterLightFirst[ c + 1 ] += clusterLightFirst[ c ];
+			total = clusterLightFirst[ numClusters ];
+			clusterLightNums = safe_malloc( ( total + 1 ) * sizeof( *clusterLightNums ) );
+			fill = safe_malloc( numClusters * sizeof( *fill ) );
+			memcpy( fill, clusterLightFirst, numClusters * sizeof( *fill ) );
+		}
+	}
+
+	/* free bounds */
+	free( fill );
+	free( clusterMins );
+	free( clusterMaxs );
+
+	/* emit some statistics */
+	Sys_FPrintf( SYS_VRB, "%9d cluster light references\n", total );
+}
+
+
+
 /*
    SetupEnvelopes()
    calculates each light's effective envelope,
@@ -3184,6 +3631,9 @@ void SetupEnvelopes( qboolean forGrid, qboolean fastFlag ){
 	light_t     *buckets[ 256 ];
 
 
+	/* the cluster light lists point into the light list */
+	FreeClusterLights();
+
 	/* early out for weird cases where there are no lights */
 	if ( lights == NULL ) {
 		return;
@@ -3477,6 +3927,11 @@ void SetupEnvelopes( qboolean forGrid, qboolean fastFlag ){
 		}
 	}
 
+	/* build per-cluster light lists for surface lighting */
+	if ( !forGrid ) {
+		SetupClusterLights();
+	}
+
 	/* emit some statistics */
 	Sys_Printf( "%9d total lights\n", numLights );
 	Sys_Printf( "%9d culled lights\n", numCulledLights );
@@ -3489,11 +3944,16 @@ void SetupEnvelopes( qboolean forGrid, qboolean fastFlag ){
    creates a list of lights that affect the given bounding box and pvs clusters (bsp leaves)
  */
 
+static int CompareLightNum( const void *a, const void *b ){
+	return *( (const int*) a ) - *( (const int*) b );
+}
+
 void CreateTraceLightsForBounds( vec3_t mins, vec3_t maxs, vec3_t normal, int numClusters, int *clusters, int flags, trace_t *trace ){
-	int i;
-	light_t     *light;
+	int i, j, c, numCandidates, *candidates;
+	light_t     *member, *light, *cl;
 	vec3_t origin, dir, nullVector = { 0.0f, 0.0f, 0.0f };
 	float radius, dist, length;
+	byte        *useCluster;
 
 
 	/* potential pre-setup  */
@@ -3524,10 +3984,73 @@ void CreateTraceLightsForBounds( vec3_t mins, vec3_t maxs, vec3_t normal, int nu
 		length = 0;
 	}
 
-	/* test each light and see if it reaches the sphere */
+	/* bounce clusters far enough away (relative to their size) stand in for their members */
+	useCluster = NULL;
+	if ( numBounceClusters > 0 ) {
+		useCluster = safe_malloc( numBounceClusters );
+		for ( i = 0; i < numBounceClusters; i++ )
+		{
+			cl = bounceClusters[ i ];
+			VectorSubtract( cl->origin, origin, dir );
+			dist = VectorLength( dir ) - radius;
+			useCluster[ i ] = ( dist > 0.0f && cl->bounceClusterRadius < dist * bounceClusterRatio ) ? 1 : 0;
+		}
+	}
+
+	/* gather the candidate lights from the per-cluster light lists */
+	candidates = NULL;
+	numCandidates = 0;
+	if ( numClusters > 0 && clusters != NULL && clusterLightsByNum != NULL ) {
+		j = numClusterLightSuns;
+		for ( i = 0; i < numClusters; i++ )
+		{
+			if ( clusters[ i ] >= 0 && clusters[ i ] < numClusterLightClusters ) {
+				j += clusterLightFirst[ clusters[ i ] + 1 ] - clusterLightFirst[ clusters[ i ] ];
+			}
+		}
+		candidates = safe_malloc( ( j + 1 ) * sizeof( *candidates ) );
+		memcpy( candidates, clusterLightSuns, numClusterLightSuns * sizeof( *candidates ) );
+		numCandidates = numClusterLightSuns;
+		for ( i = 0; i < numClusters; i++ )
+		{
+			c = clusters[ i ];
+			if ( c >= 0 && c < numClusterLightClusters ) {
+				j = clusterLightFirst[ c + 1 ] - clusterLightFirst[ c ];
+				memcpy( &candidates[ numCandidates ], &clusterLightNums[ clusterLightFirst[ c ] ], j * sizeof( *candidates ) );
+				numCandidates += j;
+			}
+		}
+
+		/* restore light list order (sorted by style) and drop duplicates */
+		if ( numClusters > 1 || numClusterLightSuns > 0 ) {
+			qsort( candidates, numCandidates, sizeof( *candidates ), CompareLightNum );
+			for ( i = 0, j = 0; i < numCandidates; i++ )
+			{
+				if ( j == 0 || candidates[ i ] != candidates[ j - 1 ] ) {
+					candidates[ j++ ] = candidates[ i ];
+				}
+			}
+			numCandidates = j;
+		}
+	}
+
+	/* test each light (candidates, or the whole list) and see if it reaches the sphere */
 	/* note: the attenuation code MUST match LightingAtSample() */
-	for ( light = lights; light; light = light->next )
+	for ( i = 0, member = lights; candidates != NULL ? i < numCandidates : member != NULL; i++, member = member->next )
 	{
+		/* substitute the cluster for its first member, skip the rest */
+		if ( candidates != NULL ) {
+			member = clusterLightsByNum[ candidates[ i ] ];
+		}
+		light = member;
+		if ( member->bounceCluster != NULL && useCluster[ member->bounceCluster->bounceClusterNum ] ) {
+			if ( useCluster[ member->bounceCluster->bounceClusterNum ] == 2 ) {
+				continue;
+			}
+			useCluster[ member->bounceCluster->bounceClusterNum ] = 2;
+			light = member->bounceCluster;
+		}
+
 		/* check zero sized envelope */
 		if ( light->envelope <= 0 ) {
 			lightsEnvelopeCulled++;
@@ -3546,17 +4069,17 @@ void CreateTraceLightsForBounds( vec3_t mins, vec3_t maxs, vec3_t normal, int nu
 				continue;
 			}
 
-			/* check against pvs cluster */
-			if ( numClusters > 0 && clusters != NULL ) {
-				for ( i = 0; i < numClusters; i++ )
+			/* check against pvs cluster (candidates already passed it when the cluster lists were built) */
+			if ( candidates == NULL && numClusters > 0 && clusters != NULL ) {
+				for ( c = 0; c < numClusters; c++ )
 				{
-					if ( ClusterVisible( light->cluster, clusters[ i ] ) ) {
+					if ( ClusterVisible( light->cluster, clusters[ c ] ) ) {
 						break;
 					}
 				}
 
 				/* fixme! */
-				if ( i == numClusters ) {
+				if ( c == numClusters ) {
 					lightsClusterCulled++;
 					continue;
 				}
@@ -3609,6 +4132,14 @@ void CreateTraceLightsForBounds( vec3_t mins, vec3_t maxs, vec3_t normal, int nu
 
 	/* make last night null */
 	trace->lights[ trace->numLights ] = NULL;
+
+	/* free cluster flags and candidates */
+	if ( useCluster != NULL ) {
+		free( useCluster );
+	}
+	if ( candidates != NULL ) {
+		free( candidates );
+	}
 }
 
 
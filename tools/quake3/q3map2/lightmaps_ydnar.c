@@ -397,19 +397,20 @@ void FinishRawLightmap( rawLightmap_t *lm ){
 	}
 	memset( lm->superLuxels[ 0 ], 0, size );
 
-	/* allocate origin map storage */
-	size = lm->sw * lm->sh * SUPER_ORIGIN_SIZE * sizeof( float );
-	if ( lm->superOrigins == NULL ) {
-		lm->superOrigins = safe_malloc( size );
-	}
-	memset( lm->superOrigins, 0, size );
+	/* allocate origin and normal map storage (-superspill allocates them on use, see UnspillRawLightmap) */
+	if ( !superSpill ) {
+		size = lm->sw * lm->sh * SUPER_ORIGIN_SIZE * sizeof( float );
+		if ( lm->superOrigins == NULL ) {
+			lm->superOrigins = safe_malloc( size );
+		}
+		memset( lm->superOrigins, 0, size );
 
-	/* allocate normal map storage */
-	size = lm->sw * lm->sh * SUPER_NORMAL_SIZE * sizeof( float );
-	if ( lm->superNormals == NULL ) {
-		lm->superNormals = safe_malloc( size );
+		size = lm->sw * lm->sh * SUPER_NORMAL_SIZE * sizeof( float );
+		if ( lm->superNormals == NULL ) {
+			lm->superNormals = safe_malloc( size );
+		}
+		memset( lm->superNormals, 0, size );
 	}
-	memset( lm->superNormals, 0, size );
 
 	/* allocate cluster map storage */
 	size = lm->sw * lm->sh * sizeof( int );
@@ -444,6 +445,162 @@ void FinishRawLightmap( rawLightmap_t *lm ){
 
 
 
+/*
+   -superspill
+   raw lightmap origins and normals are only needed while a lightmap is being
+   mapped, dirtied or lit, so they can be paged out to a scratch file next to
+   the bsp in between. lightmaps are processed one per thread, so only about
+   numthreads of them are resident at once
+ */
+
+static FILE *superSpillFile = NULL;
+static char superSpillName[ 1024 ];
+static long long superSpillSize = 0;
+
+
+
+/*
+   SeekSuperSpill()
+   seeks the scratch file, which may grow well past 2GB
+ */
+
+static int SeekSuperSpill( long long offset ){
+#ifdef WIN32
+	return _fseeki64( superSpillFile, offset, SEEK_SET );
+#else
+	return fseeko( superSpillFile, (off_t) offset, SEEK_SET );
+#endif
+}
+
+
+
+/*
+   SpillRawLightmap()
+   writes a raw lightmap's origins and normals to the -superspill file and frees them.
+   the slot is only written on the first spill and when the resident copy was marked
+   modified since (DirtyRawLightmap() stores dirt in the normals), the passes that just
+   read them (every bounce) only drop the resident copy
+ */
+
+void SpillRawLightmap( rawLightmap_t *lm ){
+	int originSize, normalSize;
+
+
+	/* opt-in, and only resident lightmaps */
+	if ( !superSpill || lm->superOrigins == NULL ) {
+		return;
+	}
+
+	/* get sizes */
+	originSize = lm->sw * lm->sh * SUPER_ORIGIN_SIZE * sizeof( float );
+	normalSize = lm->sw * lm->sh * SUPER_NORMAL_SIZE * sizeof( float );
+
+	/* already on disk and unchanged since */
+	if ( lm->superSpilled && !lm->superSpillModified ) {
+		free( lm->superOrigins );
+		free( lm->superNormals );
+		lm->superOrigins = NULL;
+		lm->superNormals = NULL;
+		return;
+	}
+
+	/* the file is shared by all threads */
+	ThreadLock();
+
+	/* open the scratch file on first use */
+	if ( superSpillFile == NULL ) {
+		strcpy( superSpillName, source );
+		StripExtension( superSpillName );
+		strcat( superSpillName, ".superspill" );
+		superSpillFile = fopen( superSpillName, "w+b" );
+		if ( superSpillFile == NULL ) {
+			Error( "Unable to open %s for -superspill", superSpillName );
+		}
+		superSpillSize = 0;
+	}
+
+	/* each lightmap gets a fixed slot */
+	if ( !lm->superSpilled ) {
+		lm->superSpillOffset = superSpillSize;
+		superSpillSize += originSize + normalSize;
+		lm->superSpilled = qtrue;
+	}
+	lm->superSpillModified = qfalse;
+
+	/* write */
+	if ( SeekSuperSpill( lm->superSpillOffset ) != 0 ||
+		 fwrite( lm->superOrigins, 1, originSize, superSpillFile ) != (size_t) originSize ||
+		 fwrite( lm->superNormals, 1, normalSize, superSpillFile ) != (size_t) normalSize ) {
+		Error( "Error writing %s (disk full?)", superSpillName );
+	}
+	ThreadUnlock();
+
+	/* free */
+	free( lm->superOrigins );
+	free( lm->superNormals );
+	lm->superOrigins = NULL;
+	lm->superNormals = NULL;
+}
+
+
+
+/*
+   UnspillRawLightmap()
+   makes a raw lightmap's origins and normals resident again, zeroed if never spilled
+ */
+
+void UnspillRawLightmap( rawLightmap_t *lm ){
+	int originSize, normalSize;
+
+
+	/* already resident? */
+	if ( !superSpill || lm->superOrigins != NULL ) {
+		return;
+	}
+
+	/* allocate */
+	originSize = lm->sw * lm->sh * SUPER_ORIGIN_SIZE * sizeof( float );
+	normalSize = lm->sw * lm->sh * SUPER_NORMAL_SIZE * sizeof( float );
+	lm->superOrigins = safe_malloc( originSize );
+	lm->superNormals = safe_malloc( normalSize );
+
+	/* not mapped yet */
+	if ( !lm->superSpilled ) {
+		memset( lm->superOrigins, 0, originSize );
+		memset( lm->superNormals, 0, normalSize );
+		return;
+	}
+
+	/* read */
+	ThreadLock();
+	if ( SeekSuperSpill( lm->superSpillOffset ) != 0 ||
+		 fread( lm->superOrigins, 1, originSize, superSpillFile ) != (size_t) originSize ||
+		 fread( lm->superNormals, 1, normalSize, superSpillFile ) != (size_t) normalSize ) {
+		Error( "Error reading %s", superSpillName );
+	}
+	ThreadUnlock();
+}
+
+
+
+/*
+   CloseSuperSpill()
+   closes and deletes the -superspill scratch file. also called at exit, so an
+   Error() part way through lighting doesn't leave the file behind
+ */
+
+void CloseSuperSpill( void ){
+	if ( superSpillFile == NULL ) {
+		return;
+	}
+	Sys_Printf( "%9d MB paged out to %s\n", (int) ( superSpillSize >> 20 ), superSpillName );
+	fclose( superSpillFile );
+	superSpillFile = NULL;
+	remove( superSpillName );
+}
+
+
+
 /*
    AddPatchToRawLightmap()
    projects a lightmap for a patch surface
@@ -1528,6 +1685,223 @@ static qboolean MergeBSPLuxels( rawLightmap_t *a, int aNum, rawLightmap_t *b, in
 
 
 
+/*
+   collapse keys
+   a surface lightmap can only be collapsed into one with a matching key
+   (see CompareBSPLuxels), so the candidates are sorted into buckets first
+   and each bucket is compared independently
+ */
+
+typedef struct collapseKey_s
+{
+	rawLightmap_t       *lm;
+	int lightmapNum;
+}
+collapseKey_t;
+
+static collapseKey_t    *collapseKeys = NULL;
+static int numCollapseKeys = 0;
+static int              *collapseBuckets = NULL;
+static int numCollapseBuckets = 0;
+static int numCollapseTwins, numCollapseTwinLuxels;
+
+
+
+/*
+   CompareCollapseBucket()
+   qsort-style compare of the parts of two collapse keys that CompareBSPLuxels requires to match
+ */
+
+static int CompareCollapseBucket( const collapseKey_t *a, const collapseKey_t *b ){
+	int aStyled, bStyled;
+
+
+	/* custom size */
+	if ( a->lm->customWidth != b->lm->customWidth ) {
+		return a->lm->customWidth - b->lm->customWidth;
+	}
+	if ( a->lm->customHeight != b->lm->customHeight ) {
+		return a->lm->customHeight - b->lm->customHeight;
+	}
+
+	/* brightness */
+	if ( a->lm->brightness < b->lm->brightness ) {
+		return -1;
+	}
+	if ( a->lm->brightness > b->lm->brightness ) {
+		return 1;
+	}
+
+	/* styled lightmaps never collapse to non-styled lightmaps when there is _minlight */
+	if ( minLight[ 0 ] || minLight[ 1 ] || minLight[ 2 ] ) {
+		aStyled = ( a->lightmapNum != 0 );
+		bStyled = ( b->lightmapNum != 0 );
+		if ( aStyled != bStyled ) {
+			return aStyled - bStyled;
+		}
+	}
+
+	/* solid color */
+	if ( a->lm->solid[ a->lightmapNum ] != b->lm->solid[ b->lightmapNum ] ) {
+		return a->lm->solid[ a->lightmapNum ] - b->lm->solid[ b->lightmapNum ];
+	}
+	if ( a->lm->solid[ a->lightmapNum ] ) {
+		return 0;
+	}
+
+	/* nonsolid lightmaps must have the same size */
+	if ( a->lm->w != b->lm->w ) {
+		return a->lm->w - b->lm->w;
+	}
+	return a->lm->h - b->lm->h;
+}
+
+
+
+/*
+   CompareCollapseKeys()
+   qsort callback that buckets collapse keys, keeping raw lightmap order within a bucket
+ */
+
+static int CompareCollapseKeys( const void *a, const void *b ){
+	const collapseKey_t *ak, *bk;
+	int diff;
+
+
+	/* bucket first */
+	ak = (const collapseKey_t*) a;
+	bk = (const collapseKey_t*) b;
+	diff = CompareCollapseBucket( ak, bk );
+	if ( diff != 0 ) {
+		return diff;
+	}
+
+	/* then the original raw lightmap order */
+	if ( ak->lm != bk->lm ) {
+		return ak->lm < bk->lm ? -1 : 1;
+	}
+	return ak->lightmapNum - bk->lightmapNum;
+}
+
+
+
+/*
+   CollapseBucket()
+   finds and merges virtually identical lightmaps within one collapse bucket
+   in the same order a full compare of every raw lightmap would use
+ */
+
+static void CollapseBucket( int bucketNum ){
+	int i, j;
+	collapseKey_t       *a, *b;
+	rawLightmap_t       *lm, *lm2;
+
+
+	/* walk the bucket */
+	for ( i = collapseBuckets[ bucketNum ]; i < collapseBuckets[ bucketNum + 1 ]; i++ )
+	{
+		/* early out */
+		a = &collapseKeys[ i ];
+		lm = a->lm;
+		if ( lm->twins[ a->lightmapNum ] != NULL ) {
+			continue;
+		}
+
+		/* find all later lightmaps that are virtually identical to this one */
+		for ( j = i + 1; j < collapseBuckets[ bucketNum + 1 ]; j++ )
+		{
+			/* early outs */
+			b = &collapseKeys[ j ];
+			lm2 = b->lm;
+			if ( lm2 == lm || lm2->twins[ b->lightmapNum ] != NULL ) {
+				continue;
+			}
+
+			/* compare them */
+			if ( CompareBSPLuxels( lm, a->lightmapNum, lm2, b->lightmapNum ) ) {
+				/* merge and set twin */
+				if ( MergeBSPLuxels( lm, a->lightmapNum, lm2, b->lightmapNum ) ) {
+					lm2->twins[ b->lightmapNum ] = lm;
+					lm2->twinNums[ b->lightmapNum ] = a->lightmapNum;
+
+					/* lightmaps can be in more than one bucket, one per style */
+					ThreadLock();
+					numCollapseTwins++;
+					numCollapseTwinLuxels += ( lm->w * lm->h );
+					if ( a->lightmapNum > 0 ) {
+						lm->numStyledTwins++;
+					}
+					ThreadUnlock();
+				}
+			}
+		}
+	}
+}
+
+
+
+/*
+   CollapseLightmaps()
+   collapses non-unique surface lightmaps into twins, bucketed and threaded
+ */
+
+static void CollapseLightmaps( void ){
+	int i, lightmapNum;
+	rawLightmap_t       *lm;
+
+
+	/* set all twin refs to null */
+	for ( i = 0; i < numRawLightmaps; i++ )
+	{
+		for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
+		{
+			rawLightmaps[ i ].twins[ lightmapNum ] = NULL;
+			rawLightmaps[ i ].twinNums[ lightmapNum ] = -1;
+			rawLightmaps[ i ].numStyledTwins = 0;
+		}
+	}
+
+	/* allocate keys (raw lightmap count doesn't change between bounces) */
+	if ( collapseKeys == NULL ) {
+		collapseKeys = safe_malloc( numRawLightmaps * MAX_LIGHTMAPS * sizeof( *collapseKeys ) );
+		collapseBuckets = safe_malloc( ( numRawLightmaps * MAX_LIGHTMAPS + 1 ) * sizeof( *collapseBuckets ) );
+	}
+
+	/* make a key for each stored lightmap */
+	numCollapseKeys = 0;
+	for ( i = 0; i < numRawLightmaps; i++ )
+	{
+		lm = &rawLightmaps[ i ];
+		for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
+		{
+			if ( lm->bspLuxels[ lightmapNum ] == NULL ) {
+				continue;
+			}
+			collapseKeys[ numCollapseKeys ].lm = lm;
+			collapseKeys[ numCollapseKeys ].lightmapNum = lightmapNum;
+			numCollapseKeys++;
+		}
+	}
+
+	/* sort them into buckets */
+	qsort( collapseKeys, numCollapseKeys, sizeof( *collapseKeys ), CompareCollapseKeys );
+	numCollapseBuckets = 0;
+	for ( i = 0; i < numCollapseKeys; i++ )
+	{
+		if ( i == 0 || CompareCollapseBucket( &collapseKeys[ i - 1 ], &collapseKeys[ i ] ) != 0 ) {
+			collapseBuckets[ numCollapseBuckets++ ] = i;
+		}
+	}
+	collapseBuckets[ numCollapseBuckets ] = numCollapseKeys;
+
+	/* collapse each bucket */
+	numCollapseTwins = 0;
+	numCollapseTwinLuxels = 0;
+	RunThreadsOnIndividual( numCollapseBuckets, qfalse, CollapseBucket );
+}
+
+
+
 /*
    ApproximateLuxel()
    determines if a single luxel is can be approximated with the interpolated vertex rgba
@@ -1687,7 +2061,7 @@ static qboolean ApproximateTriangle_r( rawLightmap_t *lm, bspDrawVert_t *dv[ 3 ]
  */
 
 static qboolean ApproximateLightmap( rawLightmap_t *lm ){
-	int n, num, i, x, y, pw[ 5 ], r;
+	int n, num, i, x, y, pw[ 5 ], r, numForced, numApproximated;
 	bspDrawSurface_t    *ds;
 	surfaceInfo_t       *info;
 	mesh_t src, *subdivided, *mesh;
@@ -1718,6 +2092,8 @@ static qboolean ApproximateLightmap( rawLightmap_t *lm ){
 
 	/* assume reduced until shadow detail is found */
 	approximated = qtrue;
+	numForced = 0;
+	numApproximated = 0;
 
 	/* walk the list of surfaces on this raw lightmap */
 	for ( n = 0; n < lm->numLightSurfaces; n++ )
@@ -1745,7 +2121,7 @@ static qboolean ApproximateLightmap( rawLightmap_t *lm ){
 			 ( info->maxs[ 1 ] - info->mins[ 1 ] ) <= ( 2.0f * info->sampleSize ) &&
 			 ( info->maxs[ 2 ] - info->mins[ 2 ] ) <= ( 2.0f * info->sampleSize ) ) {
 			info->approximated = qtrue;
-			numSurfsVertexForced++;
+			numForced++;
 			continue;
 		}
 
@@ -1828,16 +2204,35 @@ static qboolean ApproximateLightmap( rawLightmap_t *lm ){
 			approximated = qfalse;
 		}
 		else{
-			numSurfsVertexApproximated++;
+			numApproximated++;
 		}
 	}
 
+	/* add to the totals (this runs threaded) */
+	ThreadLock();
+	numSurfsVertexForced += numForced;
+	numSurfsVertexApproximated += numApproximated;
+	ThreadUnlock();
+
 	/* return */
 	return approximated;
 }
 
 
 
+/*
+   ApproximateRawLightmap()
+   tests a raw lightmap for vertex color approximation ahead of FindOutLightmaps()
+ */
+
+static byte *approximatedLightmaps = NULL;
+
+static void ApproximateRawLightmap( int rawLightmapNum ){
+	approximatedLightmaps[ rawLightmapNum ] = ApproximateLightmap( &rawLightmaps[ rawLightmapNum ] );
+}
+
+
+
 /*
    TestOutLightmapStamp()
    tests a stamp on a given lightmap for validity
@@ -1956,8 +2351,8 @@ static void FindOutLightmaps( rawLightmap_t *lm ){
 	for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
 		lm->outLightmapNums[ lightmapNum ] = -3;
 
-	/* can this lightmap be approximated with vertex color? */
-	if ( ApproximateLightmap( lm ) ) {
+	/* can this lightmap be approximated with vertex color? (see ApproximateRawLightmap) */
+	if ( approximatedLightmaps[ lm - rawLightmaps ] ) {
 		return;
 	}
 
@@ -2298,382 +2693,408 @@ static int CompareRawLightmap( const void *a, const void *b ){
 
 
 /*
-   StoreSurfaceLightmaps()
-   stores the surface lightmaps into the bsp as byte rgb triplets
+   SubsampleRawLightmap()
+   averages a raw lightmap's supersampled luxels into its bsp (and radiosity) luxels
+   and decides if it is a solid color. called threaded from StoreSurfaceLightmaps()
  */
 
-void StoreSurfaceLightmaps( void ){
-	int i, j, k, x, y, lx, ly, sx, sy, *cluster, mappedSamples;
-	int style, size, lightmapNum, lightmapNum2;
-	float               *normal, *luxel, *bspLuxel, *bspLuxel2, *radLuxel, samples, occludedSamples;
+static int numUsedLuxels;
+
+static void SubsampleRawLightmap( int rawLightmapNum ){
+	int j, x, y, lx, ly, sx, sy, *cluster, mappedSamples;
+	int size, lightmapNum, numUsed, numSolid;
+	float               *luxel, *bspLuxel, *bspLuxel2, *radLuxel, samples, occludedSamples;
 	vec3_t sample, occludedSample, dirSample, colorMins, colorMaxs;
 	float               *deluxel, *bspDeluxel, *bspDeluxel2;
-	byte                *lb;
-	int numUsed, numTwins, numTwinLuxels, numStored;
-	float lmx, lmy, efficiency;
-	vec3_t color;
-	bspDrawSurface_t    *ds, *parent, dsTemp;
-	surfaceInfo_t       *info;
-	rawLightmap_t       *lm, *lm2;
-	outLightmap_t       *olm;
-	bspDrawVert_t       *dv, *ydv, *dvParent;
-	char dirname[ 1024 ], filename[ 1024 ];
-	shaderInfo_t        *csi;
-	char lightmapName[ 128 ];
-	char                *rgbGenValues[ 256 ];
-	char                *alphaGenValues[ 256 ];
-
-
-	/* note it */
-	Sys_Printf( "--- StoreSurfaceLightmaps ---\n" );
-
-	/* setup */
-	strcpy( dirname, source );
-	StripExtension( dirname );
-	memset( rgbGenValues, 0, sizeof( rgbGenValues ) );
-	memset( alphaGenValues, 0, sizeof( alphaGenValues ) );
-
-	/* -----------------------------------------------------------------
-	   average the sampled luxels into the bsp luxels
-	   ----------------------------------------------------------------- */
+	rawLightmap_t       *lm;
 
-	/* note it */
-	Sys_FPrintf( SYS_VRB, "Subsampling..." );
 
-	/* walk the list of raw lightmaps */
+	/* get lightmap */
+	lm = &rawLightmaps[ rawLightmapNum ];
 	numUsed = 0;
-	numTwins = 0;
-	numTwinLuxels = 0;
-	numSolidLightmaps = 0;
-	for ( i = 0; i < numRawLightmaps; i++ )
-	{
-		/* get lightmap */
-		lm = &rawLightmaps[ i ];
+	numSolid = 0;
 
-		/* walk individual lightmaps */
-		for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
-		{
-			/* early outs */
-			if ( lm->superLuxels[ lightmapNum ] == NULL ) {
-				continue;
-			}
+	/* walk individual lightmaps */
+	for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
+	{
+		/* early outs */
+		if ( lm->superLuxels[ lightmapNum ] == NULL ) {
+			continue;
+		}
 
-			/* allocate bsp luxel storage */
-			if ( lm->bspLuxels[ lightmapNum ] == NULL ) {
-				size = lm->w * lm->h * BSP_LUXEL_SIZE * sizeof( float );
-				lm->bspLuxels[ lightmapNum ] = safe_malloc( size );
-				memset( lm->bspLuxels[ lightmapNum ], 0, size );
-			}
+		/* allocate bsp luxel storage */
+		if ( lm->bspLuxels[ lightmapNum ] == NULL ) {
+			size = lm->w * lm->h * BSP_LUXEL_SIZE * sizeof( float );
+			lm->bspLuxels[ lightmapNum ] = safe_malloc( size );
+			memset( lm->bspLuxels[ lightmapNum ], 0, size );
+		}
 
-			/* allocate radiosity lightmap storage */
-			if ( bounce ) {
-				size = lm->w * lm->h * RAD_LUXEL_SIZE * sizeof( float );
-				if ( lm->radLuxels[ lightmapNum ] == NULL ) {
-					lm->radLuxels[ lightmapNum ] = safe_malloc( size );
-				}
-				memset( lm->radLuxels[ lightmapNum ], 0, size );
+		/* allocate radiosity lightmap storage */
+		if ( bounce ) {
+			size = lm->w * lm->h * RAD_LUXEL_SIZE * sizeof( float );
+			if ( lm->radLuxels[ lightmapNum ] == NULL ) {
+				lm->radLuxels[ lightmapNum ] = safe_malloc( size );
 			}
+			memset( lm->radLuxels[ lightmapNum ], 0, size );
+		}
 
-			/* average supersampled luxels */
-			for ( y = 0; y < lm->h; y++ )
+		/* average supersampled luxels */
+		for ( y = 0; y < lm->h; y++ )
+		{
+			for ( x = 0; x < lm->w; x++ )
 			{
-				for ( x = 0; x < lm->w; x++ )
+				/* subsample */
+				samples = 0.0f;
+				occludedSamples = 0.0f;
+				mappedSamples = 0;
+				VectorClear( sample );
+				VectorClear( occludedSample );
+				VectorClear( dirSample );
+				for ( ly = 0; ly < superSample; ly++ )
 				{
-					/* subsample */
-					samples = 0.0f;
-					occludedSamples = 0.0f;
-					mappedSamples = 0;
-					VectorClear( sample );
-					VectorClear( occludedSample );
-					VectorClear( dirSample );
-					for ( ly = 0; ly < superSample; ly++ )
+					for ( lx = 0; lx < superSample; lx++ )
 					{
-						for ( lx = 0; lx < superSample; lx++ )
-						{
-							/* sample luxel */
-							sx = x * superSample + lx;
-							sy = y * superSample + ly;
-							luxel = SUPER_LUXEL( lightmapNum, sx, sy );
-							deluxel = SUPER_DELUXEL( sx, sy );
-							normal = SUPER_NORMAL( sx, sy );
-							cluster = SUPER_CLUSTER( sx, sy );
+						/* sample luxel */
+						sx = x * superSample + lx;
+						sy = y * superSample + ly;
+						luxel = SUPER_LUXEL( lightmapNum, sx, sy );
+						deluxel = SUPER_DELUXEL( sx, sy );
+						cluster = SUPER_CLUSTER( sx, sy );
+
+						/* sample deluxemap */
+						if ( deluxemap && lightmapNum == 0 ) {
+							VectorAdd( dirSample, deluxel, dirSample );
+						}
 
-							/* sample deluxemap */
-							if ( deluxemap && lightmapNum == 0 ) {
-								VectorAdd( dirSample, deluxel, dirSample );
-							}
+						/* keep track of used/occluded samples */
+						if ( *cluster != CLUSTER_UNMAPPED ) {
+							mappedSamples++;
+						}
+
+						/* handle lightmap border? */
+						if ( lightmapBorder && ( sx == 0 || sx == ( lm->sw - 1 ) || sy == 0 || sy == ( lm->sh - 1 ) ) && luxel[ 3 ] > 0.0f ) {
+							VectorSet( sample, 255.0f, 0.0f, 0.0f );
+							samples += 1.0f;
+						}
 
-							/* keep track of used/occluded samples */
-							if ( *cluster != CLUSTER_UNMAPPED ) {
-								mappedSamples++;
+						/* handle debug */
+						else if ( debug && *cluster < 0 ) {
+							if ( *cluster == CLUSTER_UNMAPPED ) {
+								VectorSet( luxel, 255, 204, 0 );
+							}
+							else if ( *cluster == CLUSTER_OCCLUDED ) {
+								VectorSet( luxel, 255, 0, 255 );
 							}
+							else if ( *cluster == CLUSTER_FLOODED ) {
+								VectorSet( luxel, 0, 32, 255 );
+							}
+							VectorAdd( occludedSample, luxel, occludedSample );
+							occludedSamples += 1.0f;
+						}
 
-							/* handle lightmap border? */
-							if ( lightmapBorder && ( sx == 0 || sx == ( lm->sw - 1 ) || sy == 0 || sy == ( lm->sh - 1 ) ) && luxel[ 3 ] > 0.0f ) {
-								VectorSet( sample, 255.0f, 0.0f, 0.0f );
-								samples += 1.0f;
+						/* normal luxel handling */
+						else if ( luxel[ 3 ] > 0.0f ) {
+							/* handle lit or flooded luxels */
+							if ( *cluster > 0 || *cluster == CLUSTER_FLOODED ) {
+								VectorAdd( sample, luxel, sample );
+								samples += luxel[ 3 ];
 							}
 
-							/* handle debug */
-							else if ( debug && *cluster < 0 ) {
-								if ( *cluster == CLUSTER_UNMAPPED ) {
-									VectorSet( luxel, 255, 204, 0 );
-								}
-								else if ( *cluster == CLUSTER_OCCLUDED ) {
-									VectorSet( luxel, 255, 0, 255 );
-								}
-								else if ( *cluster == CLUSTER_FLOODED ) {
-									VectorSet( luxel, 0, 32, 255 );
-								}
+							/* handle occluded or unmapped luxels */
+							else
+							{
 								VectorAdd( occludedSample, luxel, occludedSample );
-								occludedSamples += 1.0f;
+								occludedSamples += luxel[ 3 ];
 							}
 
-							/* normal luxel handling */
-							else if ( luxel[ 3 ] > 0.0f ) {
-								/* handle lit or flooded luxels */
-								if ( *cluster > 0 || *cluster == CLUSTER_FLOODED ) {
-									VectorAdd( sample, luxel, sample );
-									samples += luxel[ 3 ];
-								}
-
-								/* handle occluded or unmapped luxels */
-								else
-								{
-									VectorAdd( occludedSample, luxel, occludedSample );
-									occludedSamples += luxel[ 3 ];
-								}
-
-								/* handle style debugging */
-								if ( debug && lightmapNum > 0 && x < 2 && y < 2 ) {
-									VectorCopy( debugColors[ 0 ], sample );
-									samples = 1;
-								}
+							/* handle style debugging */
+							if ( debug && lightmapNum > 0 && x < 2 && y < 2 ) {
+								VectorCopy( debugColors[ 0 ], sample );
+								samples = 1;
 							}
 						}
 					}
+				}
 
-					/* only use occluded samples if necessary */
-					if ( samples <= 0.0f ) {
-						VectorCopy( occludedSample, sample );
-						samples = occludedSamples;
-					}
+				/* only use occluded samples if necessary */
+				if ( samples <= 0.0f ) {
+					VectorCopy( occludedSample, sample );
+					samples = occludedSamples;
+				}
 
-					/* get luxels */
-					luxel = SUPER_LUXEL( lightmapNum, x, y );
-					deluxel = SUPER_DELUXEL( x, y );
+				/* get luxels */
+				luxel = SUPER_LUXEL( lightmapNum, x, y );
+				deluxel = SUPER_DELUXEL( x, y );
 
-					/* store light direction */
-					if ( deluxemap && lightmapNum == 0 ) {
-						VectorCopy( dirSample, deluxel );
-					}
+				/* store light direction */
+				if ( deluxemap && lightmapNum == 0 ) {
+					VectorCopy( dirSample, deluxel );
+				}
 
-					/* store the sample back in super luxels */
-					if ( samples > 0.01f ) {
-						VectorScale( sample, ( 1.0f / samples ), luxel );
-						luxel[ 3 ] = 1.0f;
-					}
+				/* store the sample back in super luxels */
+				if ( samples > 0.01f ) {
+					VectorScale( sample, ( 1.0f / samples ), luxel );
+					luxel[ 3 ] = 1.0f;
+				}
 
-					/* if any samples were mapped in any way, store ambient color */
-					else if ( mappedSamples > 0 ) {
-						if ( lightmapNum == 0 ) {
-							VectorCopy( ambientColor, luxel );
-						}
-						else{
-							VectorClear( luxel );
-						}
-						luxel[ 3 ] = 1.0f;
+				/* if any samples were mapped in any way, store ambient color */
+				else if ( mappedSamples > 0 ) {
+					if ( lightmapNum == 0 ) {
+						VectorCopy( ambientColor, luxel );
 					}
-
-					/* store a bogus value to be fixed later */
-					else
-					{
+					else{
 						VectorClear( luxel );
-						luxel[ 3 ] = -1.0f;
 					}
+					luxel[ 3 ] = 1.0f;
+				}
+
+				/* store a bogus value to be fixed later */
+				else
+				{
+					VectorClear( luxel );
+					luxel[ 3 ] = -1.0f;
 				}
 			}
+		}
 
-			/* setup */
-			lm->used = 0;
-			ClearBounds( colorMins, colorMaxs );
+		/* setup */
+		lm->used = 0;
+		ClearBounds( colorMins, colorMaxs );
 
-			/* clean up and store into bsp luxels */
-			for ( y = 0; y < lm->h; y++ )
+		/* clean up and store into bsp luxels */
+		for ( y = 0; y < lm->h; y++ )
+		{
+			for ( x = 0; x < lm->w; x++ )
 			{
-				for ( x = 0; x < lm->w; x++ )
-				{
-					/* get luxels */
-					luxel = SUPER_LUXEL( lightmapNum, x, y );
-					deluxel = SUPER_DELUXEL( x, y );
+				/* get luxels */
+				luxel = SUPER_LUXEL( lightmapNum, x, y );
+				deluxel = SUPER_DELUXEL( x, y );
 
-					/* copy light direction */
-					if ( deluxemap && lightmapNum == 0 ) {
-						VectorCopy( deluxel, dirSample );
-					}
+				/* copy light direction */
+				if ( deluxemap && lightmapNum == 0 ) {
+					VectorCopy( deluxel, dirSample );
+				}
 
-					/* is this a valid sample? */
-					if ( luxel[ 3 ] > 0.0f ) {
-						VectorCopy( luxel, sample );
-						samples = luxel[ 3 ];
-						numUsed++;
-						lm->used++;
+				/* is this a valid sample? */
+				if ( luxel[ 3 ] > 0.0f ) {
+					VectorCopy( luxel, sample );
+					samples = luxel[ 3 ];
+					numUsed++;
+					lm->used++;
 
-						/* fix negative samples */
-						for ( j = 0; j < 3; j++ )
-						{
-							if ( sample[ j ] < 0.0f ) {
-								sample[ j ] = 0.0f;
-							}
+					/* fix negative samples */
+					for ( j = 0; j < 3; j++ )
+					{
+						if ( sample[ j ] < 0.0f ) {
+							sample[ j ] = 0.0f;
 						}
 					}
-					else
+				}
+				else
+				{
+					/* nick an average value from the neighbors */
+					VectorClear( sample );
+					VectorClear( dirSample );
+					samples = 0.0f;
+
+					/* fixme: why is this disabled?? */
+					for ( sy = ( y - 1 ); sy <= ( y + 1 ); sy++ )
 					{
-						/* nick an average value from the neighbors */
-						VectorClear( sample );
-						VectorClear( dirSample );
-						samples = 0.0f;
+						if ( sy < 0 || sy >= lm->h ) {
+							continue;
+						}
 
-						/* fixme: why is this disabled?? */
-						for ( sy = ( y - 1 ); sy <= ( y + 1 ); sy++ )
+						for ( sx = ( x - 1 ); sx <= ( x + 1 ); sx++ )
 						{
-							if ( sy < 0 || sy >= lm->h ) {
+							if ( sx < 0 || sx >= lm->w || ( sx == x && sy == y ) ) {
 								continue;
 							}
 
-							for ( sx = ( x - 1 ); sx <= ( x + 1 ); sx++ )
-							{
-								if ( sx < 0 || sx >= lm->w || ( sx == x && sy == y ) ) {
-									continue;
-								}
-
-								/* get neighbor's particulars */
-								luxel = SUPER_LUXEL( lightmapNum, sx, sy );
-								if ( luxel[ 3 ] < 0.0f ) {
-									continue;
-								}
-								VectorAdd( sample, luxel, sample );
-								samples += luxel[ 3 ];
+							/* get neighbor's particulars */
+							luxel = SUPER_LUXEL( lightmapNum, sx, sy );
+							if ( luxel[ 3 ] < 0.0f ) {
+								continue;
 							}
+							VectorAdd( sample, luxel, sample );
+							samples += luxel[ 3 ];
 						}
+					}
 
-						/* no samples? */
-						if ( samples == 0.0f ) {
-							VectorSet( sample, -1.0f, -1.0f, -1.0f );
-							samples = 1.0f;
-						}
-						else
-						{
-							numUsed++;
-							lm->used++;
+					/* no samples? */
+					if ( samples == 0.0f ) {
+						VectorSet( sample, -1.0f, -1.0f, -1.0f );
+						samples = 1.0f;
+					}
+					else
+					{
+						numUsed++;
+						lm->used++;
 
-							/* fix negative samples */
-							for ( j = 0; j < 3; j++ )
-							{
-								if ( sample[ j ] < 0.0f ) {
-									sample[ j ] = 0.0f;
-								}
+						/* fix negative samples */
+						for ( j = 0; j < 3; j++ )
+						{
+							if ( sample[ j ] < 0.0f ) {
+								sample[ j ] = 0.0f;
 							}
 						}
 					}
+				}
 
-					/* scale the sample */
-					VectorScale( sample, ( 1.0f / samples ), sample );
+				/* scale the sample */
+				VectorScale( sample, ( 1.0f / samples ), sample );
 
-					/* store the sample in the radiosity luxels */
-					if ( bounce > 0 ) {
-						radLuxel = RAD_LUXEL( lightmapNum, x, y );
-						VectorCopy( sample, radLuxel );
+				/* store the sample in the radiosity luxels */
+				if ( bounce > 0 ) {
+					radLuxel = RAD_LUXEL( lightmapNum, x, y );
+					VectorCopy( sample, radLuxel );
 
-						/* if only storing bounced light, early out here */
-						if ( bounceOnly && !bouncing ) {
-							continue;
-						}
+					/* if only storing bounced light, early out here */
+					if ( bounceOnly && !bouncing ) {
+						continue;
 					}
+				}
 
-					/* store the sample in the bsp luxels */
-					bspLuxel = BSP_LUXEL( lightmapNum, x, y );
-					bspDeluxel = BSP_DELUXEL( x, y );
+				/* store the sample in the bsp luxels */
+				bspLuxel = BSP_LUXEL( lightmapNum, x, y );
+				bspDeluxel = BSP_DELUXEL( x, y );
 
-					VectorAdd( bspLuxel, sample, bspLuxel );
-					if ( deluxemap && lightmapNum == 0 ) {
-						VectorAdd( bspDeluxel, dirSample, bspDeluxel );
-					}
+				VectorAdd( bspLuxel, sample, bspLuxel );
+				if ( deluxemap && lightmapNum == 0 ) {
+					VectorAdd( bspDeluxel, dirSample, bspDeluxel );
+				}
 
-					/* add color to bounds for solid checking */
-					if ( samples > 0.0f ) {
-						AddPointToBounds( bspLuxel, colorMins, colorMaxs );
-					}
+				/* add color to bounds for solid checking */
+				if ( samples > 0.0f ) {
+					AddPointToBounds( bspLuxel, colorMins, colorMaxs );
 				}
 			}
+		}
 
-			/* set solid color */
-			lm->solid[ lightmapNum ] = qfalse;
-			VectorAdd( colorMins, colorMaxs, lm->solidColor[ lightmapNum ] );
-			VectorScale( lm->solidColor[ lightmapNum ], 0.5f, lm->solidColor[ lightmapNum ] );
-
-			/* nocollapse prevents solid lightmaps */
-			if ( noCollapse == qfalse ) {
-				/* check solid color */
-				VectorSubtract( colorMaxs, colorMins, sample );
-				if ( ( sample[ 0 ] <= SOLID_EPSILON && sample[ 1 ] <= SOLID_EPSILON && sample[ 2 ] <= SOLID_EPSILON ) ||
-					 ( lm->w <= 2 && lm->h <= 2 ) ) { /* small lightmaps get forced to solid color */
-					/* set to solid */
-					VectorCopy( colorMins, lm->solidColor[ lightmapNum ] );
-					lm->solid[ lightmapNum ] = qtrue;
-					numSolidLightmaps++;
-				}
+		/* set solid color */
+		lm->solid[ lightmapNum ] = qfalse;
+		VectorAdd( colorMins, colorMaxs, lm->solidColor[ lightmapNum ] );
+		VectorScale( lm->solidColor[ lightmapNum ], 0.5f, lm->solidColor[ lightmapNum ] );
 
-				/* if all lightmaps aren't solid, then none of them are solid */
-				if ( lm->solid[ lightmapNum ] != lm->solid[ 0 ] ) {
-					for ( y = 0; y < MAX_LIGHTMAPS; y++ )
-					{
-						if ( lm->solid[ y ] ) {
-							numSolidLightmaps--;
-						}
-						lm->solid[ y ] = qfalse;
-					}
-				}
+		/* nocollapse prevents solid lightmaps */
+		if ( noCollapse == qfalse ) {
+			/* check solid color */
+			VectorSubtract( colorMaxs, colorMins, sample );
+			if ( ( sample[ 0 ] <= SOLID_EPSILON && sample[ 1 ] <= SOLID_EPSILON && sample[ 2 ] <= SOLID_EPSILON ) ||
+				 ( lm->w <= 2 && lm->h <= 2 ) ) { /* small lightmaps get forced to solid color */
+				/* set to solid */
+				VectorCopy( colorMins, lm->solidColor[ lightmapNum ] );
+				lm->solid[ lightmapNum ] = qtrue;
+				numSolid++;
 			}
 
-			/* wrap bsp luxels if necessary */
-			if ( lm->wrap[ 0 ] ) {
-				for ( y = 0; y < lm->h; y++ )
+			/* if all lightmaps aren't solid, then none of them are solid */
+			if ( lm->solid[ lightmapNum ] != lm->solid[ 0 ] ) {
+				for ( y = 0; y < MAX_LIGHTMAPS; y++ )
 				{
-					bspLuxel = BSP_LUXEL( lightmapNum, 0, y );
-					bspLuxel2 = BSP_LUXEL( lightmapNum, lm->w - 1, y );
-					VectorAdd( bspLuxel, bspLuxel2, bspLuxel );
-					VectorScale( bspLuxel, 0.5f, bspLuxel );
-					VectorCopy( bspLuxel, bspLuxel2 );
-					if ( deluxemap && lightmapNum == 0 ) {
-						bspDeluxel = BSP_DELUXEL( 0, y );
-						bspDeluxel2 = BSP_DELUXEL( lm->w - 1, y );
-						VectorAdd( bspDeluxel, bspDeluxel2, bspDeluxel );
-						VectorScale( bspDeluxel, 0.5f, bspDeluxel );
-						VectorCopy( bspDeluxel, bspDeluxel2 );
+					if ( lm->solid[ y ] ) {
+						numSolid--;
 					}
+					lm->solid[ y ] = qfalse;
 				}
 			}
-			if ( lm->wrap[ 1 ] ) {
-				for ( x = 0; x < lm->w; x++ )
-				{
-					bspLuxel = BSP_LUXEL( lightmapNum, x, 0 );
-					bspLuxel2 = BSP_LUXEL( lightmapNum, x, lm->h - 1 );
-					VectorAdd( bspLuxel, bspLuxel2, bspLuxel );
-					VectorScale( bspLuxel, 0.5f, bspLuxel );
-					VectorCopy( bspLuxel, bspLuxel2 );
-					if ( deluxemap && lightmapNum == 0 ) {
-						bspDeluxel = BSP_DELUXEL( x, 0 );
-						bspDeluxel2 = BSP_DELUXEL( x, lm->h - 1 );
-						VectorAdd( bspDeluxel, bspDeluxel2, bspDeluxel );
-						VectorScale( bspDeluxel, 0.5f, bspDeluxel );
-						VectorCopy( bspDeluxel, bspDeluxel2 );
-					}
+		}
+
+		/* wrap bsp luxels if necessary */
+		if ( lm->wrap[ 0 ] ) {
+			for ( y = 0; y < lm->h; y++ )
+			{
+				bspLuxel = BSP_LUXEL( lightmapNum, 0, y );
+				bspLuxel2 = BSP_LUXEL( lightmapNum, lm->w - 1, y );
+				VectorAdd( bspLuxel, bspLuxel2, bspLuxel );
+				VectorScale( bspLuxel, 0.5f, bspLuxel );
+				VectorCopy( bspLuxel, bspLuxel2 );
+				if ( deluxemap && lightmapNum == 0 ) {
+					bspDeluxel = BSP_DELUXEL( 0, y );
+					bspDeluxel2 = BSP_DELUXEL( lm->w - 1, y );
+					VectorAdd( bspDeluxel, bspDeluxel2, bspDeluxel );
+					VectorScale( bspDeluxel, 0.5f, bspDeluxel );
+					VectorCopy( bspDeluxel, bspDeluxel2 );
+				}
+			}
+		}
+		if ( lm->wrap[ 1 ] ) {
+			for ( x = 0; x < lm->w; x++ )
+			{
+				bspLuxel = BSP_LUXEL( lightmapNum, x, 0 );
+				bspLuxel2 = BSP_LUXEL( lightmapNum, x, lm->h - 1 );
+				VectorAdd( bspLuxel, bspLuxel2, bspLuxel );
+				VectorScale( bspLuxel, 0.5f, bspLuxel );
+				VectorCopy( bspLuxel, bspLuxel2 );
+				if ( deluxemap && lightmapNum == 0 ) {
+					bspDeluxel = BSP_DELUXEL( x, 0 );
+					bspDeluxel2 = BSP_DELUXEL( x, lm->h - 1 );
+					VectorAdd( bspDeluxel, bspDeluxel2, bspDeluxel );
+					VectorScale( bspDeluxel, 0.5f, bspDeluxel );
+					VectorCopy( bspDeluxel, bspDeluxel2 );
 				}
 			}
 		}
 	}
 
+	/* add to the totals */
+	ThreadLock();
+	numUsedLuxels += numUsed;
+	numSolidLightmaps += numSolid;
+	ThreadUnlock();
+}
+
+
+
+/*
+   StoreSurfaceLightmaps()
+   stores the surface lightmaps into the bsp as byte rgb triplets
+   writeFiles is qfalse between radiosity bounces, where external
+   lightmap images and the map shader file are not needed yet
+ */
+
+void StoreSurfaceLightmaps( qboolean writeFiles ){
+	int i, j, k;
+	int style, lightmapNum, lightmapNum2;
+	float               *luxel;
+	byte                *lb;
+	int numTwins, numTwinLuxels, numStored;
+	float lmx, lmy, efficiency;
+	vec3_t color;
+	bspDrawSurface_t    *ds, *parent, dsTemp;
+	surfaceInfo_t       *info;
+	rawLightmap_t       *lm, *lm2;
+	outLightmap_t       *olm;
+	bspDrawVert_t       *dv, *ydv, *dvParent;
+	char dirname[ 1024 ], filename[ 1024 ];
+	shaderInfo_t        *csi;
+	char lightmapName[ 128 ];
+	char                *rgbGenValues[ 256 ];
+	char                *alphaGenValues[ 256 ];
+
+
+	/* note it */
+	Sys_Printf( "--- StoreSurfaceLightmaps ---\n" );
+
+	/* setup */
+	strcpy( dirname, source );
+	StripExtension( dirname );
+	memset( rgbGenValues, 0, sizeof( rgbGenValues ) );
+	memset( alphaGenValues, 0, sizeof( alphaGenValues ) );
+
+	/* -----------------------------------------------------------------
+	   average the sampled luxels into the bsp luxels
+	   ----------------------------------------------------------------- */
+
+	/* note it */
+	Sys_FPrintf( SYS_VRB, "Subsampling..." );
+
+	/* walk the list of raw lightmaps */
+	numUsedLuxels = 0;
+	numTwins = 0;
+	numTwinLuxels = 0;
+	numSolidLightmaps = 0;
+	RunThreadsOnIndividual( numRawLightmaps, qfalse, SubsampleRawLightmap );
+
 	/* -----------------------------------------------------------------
 	   collapse non-unique lightmaps
 	   ----------------------------------------------------------------- */
@@ -2682,66 +3103,10 @@ void StoreSurfaceLightmaps( void ){
 		/* note it */
 		Sys_FPrintf( SYS_VRB, "collapsing..." );
 
-		/* set all twin refs to null */
-		for ( i = 0; i < numRawLightmaps; i++ )
-		{
-			for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
-			{
-				rawLightmaps[ i ].twins[ lightmapNum ] = NULL;
-				rawLightmaps[ i ].twinNums[ lightmapNum ] = -1;
-				rawLightmaps[ i ].numStyledTwins = 0;
-			}
-		}
-
-		/* walk the list of raw lightmaps */
-		for ( i = 0; i < numRawLightmaps; i++ )
-		{
-			/* get lightmap */
-			lm = &rawLightmaps[ i ];
-
-			/* walk lightmaps */
-			for ( lightmapNum = 0; lightmapNum < MAX_LIGHTMAPS; lightmapNum++ )
-			{
-				/* early outs */
-				if ( lm->bspLuxels[ lightmapNum ] == NULL ||
-					 lm->twins[ lightmapNum ] != NULL ) {
-					continue;
-				}
-
-				/* find all lightmaps that are virtually identical to this one */
-				for ( j = i + 1; j < numRawLightmaps; j++ )
-				{
-					/* get lightmap */
-					lm2 = &rawLightmaps[ j ];
-
-					/* walk lightmaps */
-					for ( lightmapNum2 = 0; lightmapNum2 < MAX_LIGHTMAPS; lightmapNum2++ )
-					{
-						/* early outs */
-						if ( lm2->bspLuxels[ lightmapNum2 ] == NULL ||
-							 lm2->twins[ lightmapNum2 ] != NULL ) {
-							continue;
-						}
-
-						/* compare them */
-						if ( CompareBSPLuxels( lm, lightmapNum, lm2, lightmapNum2 ) ) {
-							/* merge and set twin */
-							if ( MergeBSPLuxels( lm, lightmapNum, lm2, lightmapNum2 ) ) {
-								lm2->twins[ lightmapNum2 ] = lm;
-								lm2->twinNums[ lightmapNum2 ] = lightmapNum;
-								numTwins++;
-								numTwinLuxels += ( lm->w * lm->h );
-
-								/* count styled twins */
-								if ( lightmapNum > 0 ) {
-									lm->numStyledTwins++;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
+		/* compare candidates bucketed by size, brightness and solidity */
+		CollapseLightmaps();
+		numTwins = numCollapseTwins;
+		numTwinLuxels = numCollapseTwinLuxels;
 	}
 
 	/* -----------------------------------------------------------------
@@ -2784,6 +3149,15 @@ void StoreSurfaceLightmaps( void ){
 	numBSPLightmaps = 0;
 	numExtLightmaps = 0;
 
+	/* test all raw lightmaps for vertex approximation up front, it only reads the lightmap */
+	if ( approximatedLightmaps == NULL ) {
+		approximatedLightmaps = safe_malloc( numRawLightmaps * sizeof( *approximatedLightmaps ) );
+	}
+	memset( approximatedLightmaps, 0, numRawLightmaps * sizeof( *approximatedLightmaps ) );
+	if ( approximateTolerance > 0 ) {
+		RunThreadsOnIndividual( numRawLightmaps, qfalse, ApproximateRawLightmap );
+	}
+
 	/* find output lightmap */
 	for ( i = 0; i < numRawLightmaps; i++ )
 	{
@@ -2858,22 +3232,28 @@ void StoreSurfaceLightmaps( void ){
 		/* external lightmap? */
 		if ( olm->lightmapNum < 0 || olm->extLightmapNum >= 0 || externalLightmaps ) {
 			/* make a directory for the lightmaps */
-			Q_mkdir( dirname );
+			if ( writeFiles ) {
+				Q_mkdir( dirname );
+			}
 
 			/* set external lightmap number */
 			olm->extLightmapNum = numExtLightmaps;
 
 			/* write lightmap */
 			sprintf( filename, "%s/" EXTERNAL_LIGHTMAP, dirname, numExtLightmaps );
-			Sys_FPrintf( SYS_VRB, "\nwriting %s", filename );
-			WriteTGA24( filename, olm->bspLightBytes, olm->customWidth, olm->customHeight, qtrue );
+			if ( writeFiles ) {
+				Sys_FPrintf( SYS_VRB, "\nwriting %s", filename );
+				WriteTGA24( filename, olm->bspLightBytes, olm->customWidth, olm->customHeight, qtrue );
+			}
 			numExtLightmaps++;
 
 			/* write deluxemap */
 			if ( deluxemap ) {
 				sprintf( filename, "%s/" EXTERNAL_LIGHTMAP, dirname, numExtLightmaps );
-				Sys_FPrintf( SYS_VRB, "\nwriting %s", filename );
-				WriteTGA24( filename, olm->bspDirBytes, olm->customWidth, olm->customHeight, qtrue );
+				if ( writeFiles ) {
+					Sys_FPrintf( SYS_VRB, "\nwriting %s", filename );
+					WriteTGA24( filename, olm->bspDirBytes, olm->customWidth, olm->customHeight, qtrue );
+				}
 				numExtLightmaps++;
 
 				if ( debugDeluxemap ) {
@@ -2883,12 +3263,12 @@ void StoreSurfaceLightmaps( void ){
 		}
 	}
 
-	if ( numExtLightmaps > 0 ) {
+	if ( numExtLightmaps > 0 && writeFiles ) {
 		Sys_FPrintf( SYS_VRB, "\n" );
 	}
 
 	/* delete unused external lightmaps */
-	for ( i = numExtLightmaps; i; i++ )
+	for ( i = numExtLightmaps; i && writeFiles; i++ )
 	{
 		/* determine if file exists */
 		sprintf( filename, "%s/" EXTERNAL_LIGHTMAP, dirname, i );
@@ -3190,10 +3570,10 @@ void StoreSurfaceLightmaps( void ){
 	numStored = numBSPLightBytes / 3;
 	efficiency = ( numStored <= 0 )
 				 ? 0
-				 : (float) numUsed / (float) numStored;
+				 : (float) numUsedLuxels / (float) numStored;
 
 	/* print stats */
-	Sys_Printf( "%9d luxels used\n", numUsed );
+	Sys_Printf( "%9d luxels used\n", numUsedLuxels );
 	Sys_Printf( "%9d luxels stored (%3.2f percent efficiency)\n", numStored, efficiency * 100.0f );
 	Sys_Printf( "%9d solid surface lightmaps\n", numSolidLightmaps );
 	Sys_Printf( "%9d identical surface lightmaps, using %d luxels\n", numTwins, numTwinLuxels );
@@ -3204,5 +3584,7 @@ void StoreSurfaceLightmaps( void ){
 	Sys_Printf( "%9d unique lightmap/shader combinations\n", numLightmapShaders );
 
 	/* write map shader file */
-	WriteMapShaderFile();
+	if ( writeFiles ) {
+		WriteMapShaderFile();
+	}
 }
@@ -85,6 +85,7 @@ char *Q_strncat( char *dst, size_t dlen, const char *src, size_t slen ) {
  */
 
 static void ExitQ3Map( void ){
+	CloseSuperSpill();
 	BSPFilesCleanup();
 	if ( mapDrawSurfs != NULL ) {
 		free( mapDrawSurfs );
@@ -590,6 +591,216 @@ int ConvertBSPMain( int argc, char **argv ){
 
 
 
+/*
+   stage globals
+   options and per-map state that one stage's run leaves behind in globals that a
+   later stage also reads. -compile restores these to their startup defaults before
+   each stage, so every stage sees exactly what a fresh q3map process would.
+   this list is maintained by hand: a new bsp or vis global that LightMain() (or a
+   later stage) reads must be added here, or -compile will silently differ from
+   running the stages separately
+ */
+
+typedef struct stageGlobal_s
+{
+	void                *var;
+	size_t size;
+}
+stageGlobal_t;
+
+#define STAGE_GLOBAL( v ) { &( v ), sizeof( v ) }
+
+static stageGlobal_t stageGlobals[] =
+{
+	/* bsp */
+	STAGE_GLOBAL( nowater ),
+	STAGE_GLOBAL( nodetail ),
+	STAGE_GLOBAL( fulldetail ),
+	STAGE_GLOBAL( nofog ),
+	STAGE_GLOBAL( nosubdivide ),
+	STAGE_GLOBAL( leaktest ),
+	STAGE_GLOBAL( verboseEntities ),
+	STAGE_GLOBAL( noCurveBrushes ),
+	STAGE_GLOBAL( notjunc ),
+	STAGE_GLOBAL( fakemap ),
+	STAGE_GLOBAL( sampleSize ),
+	STAGE_GLOBAL( useCustomInfoParms ),
+	STAGE_GLOBAL( renameModelShaders ),
+	STAGE_GLOBAL( normalEpsilon ),
+	STAGE_GLOBAL( distanceEpsilon ),
+	STAGE_GLOBAL( maxLMSurfaceVerts ),
+	STAGE_GLOBAL( maxSurfaceVerts ),
+	STAGE_GLOBAL( maxSurfaceIndexes ),
+	STAGE_GLOBAL( npDegrees ),
+	STAGE_GLOBAL( shadeAngleDegrees ),
+	STAGE_GLOBAL( bevelSnap ),
+	STAGE_GLOBAL( texRange ),
+	STAGE_GLOBAL( noHint ),
+	STAGE_GLOBAL( flat ),
+	STAGE_GLOBAL( meta ),
+	STAGE_GLOBAL( patchMeta ),
+	STAGE_GLOBAL( emitFlares ),
+	STAGE_GLOBAL( skyFixHack ),
+	STAGE_GLOBAL( debugSurfaces ),
+	STAGE_GLOBAL( debugInset ),
+	STAGE_GLOBAL( debugPortals ),
+	STAGE_GLOBAL( skyboxPresent ),
+
+	/* vis */
+	STAGE_GLOBAL( fastvis ),
+	STAGE_GLOBAL( noPassageVis ),
+	STAGE_GLOBAL( passageVisOnly ),
+	STAGE_GLOBAL( mergevis ),
+	STAGE_GLOBAL( nosort ),
+	STAGE_GLOBAL( saveprt ),
+	STAGE_GLOBAL( hint ),
+	STAGE_GLOBAL( inbase ),
+	STAGE_GLOBAL( outbase ),
+	STAGE_GLOBAL( farPlaneDist ),
+
+	{ NULL, 0 }
+};
+
+
+
+/*
+   SaveStageGlobals()
+   copies the current (default) values of the stage globals into a new buffer
+ */
+
+static byte *SaveStageGlobals( void ){
+	int i;
+	size_t size;
+	byte        *saved;
+
+
+	/* size it */
+	size = 0;
+	for ( i = 0; stageGlobals[ i ].var != NULL; i++ )
+		size += stageGlobals[ i ].size;
+
+	/* copy */
+	saved = safe_malloc( size );
+	size = 0;
+	for ( i = 0; stageGlobals[ i ].var != NULL; i++ )
+	{
+		memcpy( &saved[ size ], stageGlobals[ i ].var, stageGlobals[ i ].size );
+		size += stageGlobals[ i ].size;
+	}
+	return saved;
+}
+
+
+
+/*
+   RestoreStageGlobals()
+   puts the stage globals back to the values saved by SaveStageGlobals()
+ */
+
+static void RestoreStageGlobals( const byte *saved ){
+	int i;
+	size_t size;
+
+
+	size = 0;
+	for ( i = 0; stageGlobals[ i ].var != NULL; i++ )
+	{
+		memcpy( stageGlobals[ i ].var, &saved[ size ], stageGlobals[ i ].size );
+		size += stageGlobals[ i ].size;
+	}
+}
+
+
+
+/*
+   CompileMain()
+   runs the bsp, vis and light stages back to back in a single process, so the
+   paths, vfs, pk3 index and image cache are only set up once per map.
+   usage: q3map -compile [bsp options] [-vis [vis options]] [-light [light options]] <mapname>
+ */
+
+int CompileMain( int argc, char **argv ){
+	int i, r, visArg, lightArg;
+	int bspArgc, visArgc, lightArgc;
+	char        **stageArgv;
+	byte        *defaults;
+
+
+	/* arg checking */
+	if ( argc < 2 ) {
+		Sys_Printf( "Usage: q3map -compile [bsp options] [-vis [vis options]] [-light [light options]] <mapname>\n" );
+		return 0;
+	}
+
+	/* find the stage markers */
+	visArg = -1;
+	lightArg = -1;
+	for ( i = 1; i < ( argc - 1 ); i++ )
+	{
+		if ( !strcmp( argv[ i ], "-vis" ) && visArg < 0 && lightArg < 0 ) {
+			visArg = i;
+		}
+		else if ( !strcmp( argv[ i ], "-light" ) && lightArg < 0 ) {
+			lightArg = i;
+		}
+	}
+
+	/* get option counts for each stage */
+	bspArgc = ( visArg >= 0 ? visArg : ( lightArg >= 0 ? lightArg : argc - 1 ) ) - 1;
+	visArgc = ( visArg >= 0 ? ( lightArg >= 0 ? lightArg : argc - 1 ) - visArg - 1 : 0 );
+	lightArgc = ( lightArg >= 0 ? argc - 1 - lightArg - 1 : 0 );
+
+	/* each stage sees the same argv layout it would get from its own q3map run */
+	stageArgv = safe_malloc( sizeof( *stageArgv ) * ( argc + 1 ) );
+
+	/* nothing has run yet, so the stage globals still hold their defaults */
+	defaults = SaveStageGlobals();
+
+	/* bsp */
+	stageArgv[ 0 ] = argv[ 0 ];
+	memcpy( &stageArgv[ 1 ], &argv[ 1 ], sizeof( *stageArgv ) * bspArgc );
+	stageArgv[ bspArgc + 1 ] = argv[ argc - 1 ];
+	srand( 0 );
+	r = BSPMain( bspArgc + 2, stageArgv );
+
+	/* the bsp stage's map data isn't needed by vis or light */
+	if ( mapDrawSurfs != NULL ) {
+		free( mapDrawSurfs );
+		mapDrawSurfs = NULL;
+	}
+	numMapDrawSurfs = 0;
+
+	/* vis */
+	if ( r == 0 && visArg >= 0 ) {
+		memcpy( stageArgv, &argv[ visArg ], sizeof( *stageArgv ) * ( visArgc + 1 ) );
+		stageArgv[ visArgc + 1 ] = argv[ argc - 1 ];
+		RestoreStageGlobals( defaults );
+		srand( 0 );
+		r = VisMain( visArgc + 2, stageArgv );
+	}
+
+	/* light */
+	if ( r == 0 && lightArg >= 0 ) {
+		/* reparse shaders so bsp stage modifications don't leak into lighting */
+		FreeShaderInfo();
+
+		memcpy( stageArgv, &argv[ lightArg ], sizeof( *stageArgv ) * ( lightArgc + 1 ) );
+		stageArgv[ lightArgc + 1 ] = argv[ argc - 1 ];
+		RestoreStageGlobals( defaults );
+		srand( 0 );
+		r = LightMain( lightArgc + 2, stageArgv );
+	}
+
+	/* clean up */
+	free( defaults );
+	free( stageArgv );
+
+	/* return to sender */
+	return r;
+}
+
+
+
 /*
    main()
    q3map mojo...
@@ -653,6 +864,18 @@ int main( int argc, char **argv ){
 			numthreads = atoi( argv[ i ] );
 			argv[ i ] = NULL;
 		}
+
+		/* per-stage timings */
+		else if ( !strcmp( argv[ i ], "-timings" ) ) {
+			if ( i + 1 >= argc ) {
+				Error( "-timings requires an output file name" );
+			}
+			argv[ i ] = NULL;
+			i++;
+			timings = qtrue;
+			Q_strncpyz( timingsFile, argv[ i ], sizeof( timingsFile ) );
+			argv[ i ] = NULL;
+		}
 	}
 
 	/* init model library */
@@ -746,11 +969,19 @@ int main( int argc, char **argv ){
 		r = ConvertBSPMain( argc - 1, argv + 1 );
 	}
 
+	/* bsp, vis and light in one run */
+	else if ( !strcmp( argv[ 1 ], "-compile" ) ) {
+		r = CompileMain( argc - 1, argv + 1 );
+	}
+
 	/* ydnar: otherwise create a bsp */
 	else{
 		r = BSPMain( argc, argv );
 	}
 
+	/* write -timings output */
+	WriteTimings();
+
 	/* emit time */
 	end = I_FloatTime();
 	Sys_Printf( "%9.0f seconds elapsed\n", end - start );
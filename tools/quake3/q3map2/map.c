@@ -42,7 +42,11 @@
 
 /* undefine to make plane finding use linear sort (note: really slow) */
 #define USE_HASHING
-#define PLANE_HASHES    8192
+#define PLANE_HASHES    65536
+
+/* plane hash bin sizes: normal components are binned in 1/64ths, distance in whole units */
+#define PLANE_HASH_NORMAL_SCALE     64.0
+#define PLANE_HASH_DIST_SCALE       1.0
 
 plane_t                 *planehash[ PLANE_HASHES ];
 
@@ -85,15 +89,51 @@ qboolean PlaneEqual( plane_t *p, vec3_t normal, vec_t dist ){
 
 
 
+/*
+   PlaneHashBin()
+   quantizes a single plane component into a hash bin
+ */
+
+static int PlaneHashBin( double value, double scale ){
+	return (int) floor( value * scale );
+}
+
+
+
+/*
+   PlaneHashForBins()
+   combines quantized normal and distance bins into a plane hash index
+ */
+
+static int PlaneHashForBins( int nx, int ny, int nz, int d ){
+	unsigned int hash;
+
+
+	hash = ( (unsigned int) nx * 73856093U ) ^
+		   ( (unsigned int) ny * 19349663U ) ^
+		   ( (unsigned int) nz * 83492791U ) ^
+		   ( (unsigned int) d * 2654435761U );
+	hash ^= ( hash >> 16 );
+
+	return (int) ( hash & ( PLANE_HASHES - 1 ) );
+}
+
+
+
 /*
    AddPlaneToHash()
+   planes are hashed on quantized normal and distance so that
+   large numbers of planes sharing a distance do not pile into one chain
  */
 
 void AddPlaneToHash( plane_t *p ){
 	int hash;
 
 
-	hash = ( PLANE_HASHES - 1 ) & (int) fabs( p->dist );
+	hash = PlaneHashForBins( PlaneHashBin( p->normal[ 0 ], PLANE_HASH_NORMAL_SCALE ),
+							 PlaneHashBin( p->normal[ 1 ], PLANE_HASH_NORMAL_SCALE ),
+							 PlaneHashBin( p->normal[ 2 ], PLANE_HASH_NORMAL_SCALE ),
+							 PlaneHashBin( p->dist, PLANE_HASH_DIST_SCALE ) );
 
 	p->hash_chain = planehash[hash];
 	planehash[hash] = p;
@@ -319,7 +359,9 @@ int FindFloatPlane( vec3_t normal, vec_t dist, int numPoints, vec3_t *points )
 #ifdef USE_HASHING
 
 {
-	int i, j, hash, h;
+	int i, j, h;
+	int nx, ny, nz, nd;
+	int minBins[ 4 ], maxBins[ 4 ];
 	plane_t *p;
 	vec_t d;
 
@@ -329,13 +371,22 @@ int FindFloatPlane( vec3_t normal, vec_t dist, int numPoints, vec3_t *points )
 #else
 	SnapPlane( normal, &dist );
 #endif
-	/* hash the plane */
-	hash = ( PLANE_HASHES - 1 ) & (int) fabs( dist );
+	/* get the range of hash bins a plane within epsilon of this one can fall into */
+	for ( i = 0; i < 3; i++ )
+	{
+		minBins[ i ] = PlaneHashBin( normal[ i ] - normalEpsilon, PLANE_HASH_NORMAL_SCALE );
+		maxBins[ i ] = PlaneHashBin( normal[ i ] + normalEpsilon, PLANE_HASH_NORMAL_SCALE );
+	}
+	minBins[ 3 ] = PlaneHashBin( dist - distanceEpsilon, PLANE_HASH_DIST_SCALE );
+	maxBins[ 3 ] = PlaneHashBin( dist + distanceEpsilon, PLANE_HASH_DIST_SCALE );
 
-	/* search the border bins as well */
-	for ( i = -1; i <= 1; i++ )
+	/* search the border bins as well (almost always a single bin) */
+	for ( nx = minBins[ 0 ]; nx <= maxBins[ 0 ]; nx++ )
+	for ( ny = minBins[ 1 ]; ny <= maxBins[ 1 ]; ny++ )
+	for ( nz = minBins[ 2 ]; nz <= maxBins[ 2 ]; nz++ )
+	for ( nd = minBins[ 3 ]; nd <= maxBins[ 3 ]; nd++ )
 	{
-		h = ( hash + i ) & ( PLANE_HASHES - 1 );
+		h = PlaneHashForBins( nx, ny, nz, nd );
 		for ( p = planehash[ h ]; p != NULL; p = p->hash_chain )
 		{
 			/* do standard plane compare */
@@ -1023,16 +1074,11 @@ static void ParseRawBrush( qboolean onlyLights ){
 
 		/* bp */
 		if ( g_bBrushPrimit == BPRIMIT_OLDBRUSHES ) {
-			GetToken( qfalse );
-			shift[ 0 ] = atof( token );
-			GetToken( qfalse );
-			shift[ 1 ] = atof( token );
-			GetToken( qfalse );
-			rotate = atof( token );
-			GetToken( qfalse );
-			scale[ 0 ] = atof( token );
-			GetToken( qfalse );
-			scale[ 1 ] = atof( token );
+			GetFloatToken( qfalse, &shift[ 0 ] );
+			GetFloatToken( qfalse, &shift[ 1 ] );
+			GetFloatToken( qfalse, &rotate );
+			GetFloatToken( qfalse, &scale[ 0 ] );
+			GetFloatToken( qfalse, &scale[ 1 ] );
 		}
 
 		/* set default flags and values */
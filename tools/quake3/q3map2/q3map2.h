@@ -260,6 +260,7 @@ extern int unz_GAME_QL;
 #define LIGHT_WOLF_DEFAULT      ( LIGHT_ATTEN_LINEAR | LIGHT_ATTEN_DISTANCE | LIGHT_GRID | LIGHT_SURFACES | LIGHT_FAST )
 
 #define MAX_TRACE_TEST_NODES    256
+#define MAX_TRACE_PACKET        16
 #define DEFAULT_INHIBIT_RADIUS  1.5f
 
 #define LUXEL_EPSILON           0.125f
@@ -1290,6 +1291,10 @@ typedef struct light_s
 
 	float falloffTolerance;                 /* ydnar: minimum attenuation threshold */
 	float filterRadius;                 /* ydnar: lightmap filter radius in world units, 0 == default */
+
+	struct light_s      *bounceCluster; /* bounce light cluster this light belongs to, if any */
+	int bounceClusterNum;               /* index into bounceClusters (cluster lights only) */
+	float bounceClusterRadius;          /* distance from cluster origin to farthest member */
 }
 light_t;
 
@@ -1419,6 +1424,10 @@ typedef struct rawLightmap_s
 
 	float                   *superDeluxels; /* average light direction */
 	float                   *bspDeluxels;
+
+	qboolean superSpilled;                  /* superOrigins/superNormals are paged out to the -superspill file */
+	qboolean superSpillModified;            /* the resident copy changed since it was last written (eg: dirt) */
+	long long superSpillOffset;
 }
 rawLightmap_t;
 
@@ -1713,6 +1722,7 @@ int                         LightMain( int argc, char **argv );
 /* light_trace.c */
 void                        SetupTraceNodes( void );
 void                        TraceLine( trace_t *trace );
+void                        TraceLinePacket( trace_t *traces, int numTraces );
 float                       SetupTrace( trace_t *trace );
 
 
@@ -1721,6 +1731,7 @@ qboolean RadSampleImage( byte * pixels, int width, int height, float st[ 2 ], fl
 void                        RadLightForTriangles( int num, int lightmapNum, rawLightmap_t *lm, shaderInfo_t *si, float scale, float subdivide, clipWork_t *cw );
 void                        RadLightForPatch( int num, int lightmapNum, rawLightmap_t *lm, shaderInfo_t *si, float scale, float subdivide, clipWork_t *cw );
 void                        RadCreateDiffuseLights( void );
+void                        RadClusterDiffuseLights( void );
 void                        RadFreeLights();
 
 
@@ -1758,8 +1769,11 @@ int                         ExportLightmapsMain( int argc, char **argv );
 int                         ImportLightmapsMain( int argc, char **argv );
 
 void                        SetupSurfaceLightmaps( void );
+void                        SpillRawLightmap( rawLightmap_t *lm );
+void                        UnspillRawLightmap( rawLightmap_t *lm );
+void                        CloseSuperSpill( void );
 void                        StitchSurfaceLightmaps( void );
-void                        StoreSurfaceLightmaps( void );
+void                        StoreSurfaceLightmaps( qboolean writeFiles );
 
 
 /* exportents.c */
@@ -1791,6 +1805,7 @@ shaderInfo_t                *CustomShader( shaderInfo_t *si, char *find, char *r
 void                        EmitVertexRemapShader( char *from, char *to );
 
 void                        LoadShaderInfo( void );
+void                        FreeShaderInfo( void );
 shaderInfo_t                *ShaderInfoForShader( const char *shader );
 
 
@@ -1807,7 +1822,11 @@ void                        SwapBlock( int *block, int size );
 int                         GetLumpElements( bspHeader_t *header, int lump, int size );
 void                        *GetLump( bspHeader_t *header, int lump );
 int                         CopyLump( bspHeader_t *header, int lump, void *dest, int size );
+int                         LoadBSPFileBuffer( const char *filename, void **buffer, qboolean *mapped );
+void                        FreeBSPFileBuffer( void *buffer, int length, qboolean mapped );
 void                        AddLump( FILE *file, bspHeader_t *header, int lumpNum, const void *data, int length );
+void                        AddLumpBuffer( FILE *file, bspHeader_t *header, int lumpNum, void *data, int length );
+void                        FlushLumpWrites( void );
 
 void                        LoadBSPFile( const char *filename );
 void                        WriteBSPFile( const char *filename );
@@ -1836,6 +1855,12 @@ void                        LoadRBSPFile( const char *filename );
 void                        WriteRBSPFile( const char *filename );
 
 
+/* timing.c */
+void                        TimingBegin( const char *name );
+void                        TimingEnd( void );
+void                        WriteTimings( void );
+
+
 
 /* -------------------------------------------------------------------------------
 
@@ -1934,6 +1959,8 @@ Q_EXTERN qboolean nofog Q_ASSIGN( qfalse );
 Q_EXTERN qboolean noHint Q_ASSIGN( qfalse );                        /* ydnar */
 Q_EXTERN qboolean renameModelShaders Q_ASSIGN( qfalse );            /* ydnar */
 Q_EXTERN qboolean skyFixHack Q_ASSIGN( qfalse );                    /* ydnar */
+Q_EXTERN qboolean timings Q_ASSIGN( qfalse );                       /* -timings <file> */
+Q_EXTERN char timingsFile[ 1024 ];
 
 Q_EXTERN int patchSubdivisions Q_ASSIGN( 8 );                       /* ydnar: -patchmeta subdivisions */
 
@@ -2139,12 +2166,17 @@ Q_EXTERN int bounce Q_ASSIGN( 0 );
 Q_EXTERN qboolean bounceOnly Q_ASSIGN( qfalse );
 Q_EXTERN qboolean bouncing Q_ASSIGN( qfalse );
 Q_EXTERN qboolean bouncegrid Q_ASSIGN( qfalse );
+Q_EXTERN int bounceCheckpoint Q_ASSIGN( 0 );
 Q_EXTERN qboolean normalmap Q_ASSIGN( qfalse );
 Q_EXTERN qboolean trisoup Q_ASSIGN( qfalse );
 Q_EXTERN qboolean shade Q_ASSIGN( qfalse );
 Q_EXTERN float shadeAngleDegrees Q_ASSIGN( 0.0f );
 Q_EXTERN int superSample Q_ASSIGN( 0 );
 Q_EXTERN int lightSamples Q_ASSIGN( 1 );
+Q_EXTERN float lightSamplesThreshold Q_ASSIGN( 0.0f );
+Q_EXTERN qboolean superSpill Q_ASSIGN( qfalse );
+Q_EXTERN qboolean traceCache Q_ASSIGN( qfalse );
+Q_EXTERN int lightCoherence Q_ASSIGN( 0 );
 Q_EXTERN qboolean filter Q_ASSIGN( qfalse );
 Q_EXTERN qboolean dark Q_ASSIGN( qfalse );
 Q_EXTERN qboolean sunOnly Q_ASSIGN( qfalse );
@@ -2254,6 +2286,10 @@ Q_EXTERN int lightsClusterCulled;
 /* ydnar: radiosity */
 Q_EXTERN float diffuseSubdivide Q_ASSIGN( 256.0f );
 Q_EXTERN float minDiffuseSubdivide Q_ASSIGN( 64.0f );
+Q_EXTERN float bounceClusterSize Q_ASSIGN( 0.0f );
+Q_EXTERN float bounceClusterRatio Q_ASSIGN( 0.25f );
+Q_EXTERN int numBounceClusters Q_ASSIGN( 0 );
+Q_EXTERN light_t            **bounceClusters Q_ASSIGN( NULL );
 Q_EXTERN int numDiffuseSurfaces Q_ASSIGN( 0 );
 
 /* ydnar: list of surface information necessary for lightmap calculation */
@@ -2301,7 +2337,9 @@ Q_EXTERN int numLuxels Q_ASSIGN( 0 );
 Q_EXTERN int numLuxelsMapped Q_ASSIGN( 0 );
 Q_EXTERN int numLuxelsOccluded Q_ASSIGN( 0 );
 Q_EXTERN int numLuxelsIlluminated Q_ASSIGN( 0 );
+Q_EXTERN int numLuxelsCoherent Q_ASSIGN( 0 );
 Q_EXTERN int numVertsIlluminated Q_ASSIGN( 0 );
+Q_EXTERN int numTraces Q_ASSIGN( 0 );                               /* only counted with -timings */
 
 /* lightgrid */
 Q_EXTERN vec3_t gridMins;
@@ -2031,3 +2031,18 @@ void LoadShaderInfo( void ){
 	/* emit some statistics */
 	Sys_FPrintf( SYS_VRB, "%9d shaderInfo\n", numShaderInfo );
 }
+
+
+
+/*
+   FreeShaderInfo()
+   releases the parsed shader table so the next LoadShaderInfo() starts from scratch
+   the strings and lists hanging off each shader are not freed: CustomShader() and
+   q3map_baseShader copy whole shaderInfo_t structs, so they are shared between entries
+ */
+
+void FreeShaderInfo( void ){
+	free( shaderInfo );
+	shaderInfo = NULL;
+	numShaderInfo = 0;
+}
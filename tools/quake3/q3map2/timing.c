@@ -0,0 +1,321 @@
+/* -------------------------------------------------------------------------------
+
+   Copyright (C) 1999-2007 id Software, Inc. and contributors.
+   For a list of contributors, see the accompanying CONTRIBUTORS file.
+
+   This file is part of GtkRadiant.
+
+   GtkRadiant is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   GtkRadiant is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with GtkRadiant; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+   ----------------------------------------------------------------------------------
+
+   This code has been altered significantly from its original form, to support
+   several games based on the Quake III Arena engine, in the form of "Q3Map2."
+
+   ------------------------------------------------------------------------------- */
+
+
+
+/* marker */
+#define TIMING_C
+
+
+
+/* dependencies */
+#include "q3map2.h"
+
+#ifdef Q_UNIX
+	#include <sys/resource.h>
+#endif
+
+
+
+/* -------------------------------------------------------------------------------
+
+   this file records optional per-stage timings (-timings <file>) and writes them
+   out as a chrome trace (chrome://tracing, or any json reader). each stage notes
+   wall time, how busy each thread was, traced rays, and the memory it peaked at
+   relative to where it started.
+
+   ------------------------------------------------------------------------------- */
+
+#define MAX_TIMING_DEPTH    32
+#define MAX_TIMING_EVENTS   8192
+
+typedef struct timingScope_s
+{
+	const char          *name;
+	double start;
+	double busyTime, wallTime;
+	double threadBusy[ MAX_THREADS ];
+	int traces;
+	int startMemory, peakMemory;
+}
+timingScope_t;
+
+typedef struct timingEvent_s
+{
+	const char          *name;
+	int depth;
+	double start, duration;
+	double busyFraction;
+	int numThreads;
+	double              *threadBusy;
+	double threadWall;
+	int traces;
+	int peakMemory, peakDelta;
+}
+timingEvent_t;
+
+static timingScope_t timingStack[ MAX_TIMING_DEPTH ];
+static int timingDepth = 0;
+static timingEvent_t timingEvents[ MAX_TIMING_EVENTS ];
+static int numTimingEvents = 0;
+static double timingBase = 0.0;
+
+
+
+/*
+   ReadMemory()
+   gets the current and peak resident set size of the process in kilobytes (0 if unknown).
+   on linux the peak can be reset per stage (see ResetPeakMemory()), elsewhere it is
+   the peak of the whole process so far
+ */
+
+static void ReadMemory( int *current, int *peak ){
+#ifdef Q_UNIX
+	struct rusage usage;
+	#ifdef __linux__
+	FILE            *file;
+	char line[ 256 ];
+	#endif
+
+
+	*current = 0;
+	*peak = 0;
+
+	#ifdef __linux__
+	file = fopen( "/proc/self/status", "r" );
+	if ( file != NULL ) {
+		while ( fgets( line, sizeof( line ), file ) != NULL )
+		{
+			if ( !strncmp( line, "VmRSS:", 6 ) ) {
+				*current = atoi( line + 6 );
+			}
+			else if ( !strncmp( line, "VmHWM:", 6 ) ) {
+				*peak = atoi( line + 6 );
+			}
+		}
+		fclose( file );
+		if ( *peak > 0 ) {
+			return;
+		}
+	}
+	#endif
+
+	if ( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+		#ifdef __APPLE__
+		*peak = (int) ( usage.ru_maxrss / 1024 );
+		#else
+		*peak = (int) usage.ru_maxrss;
+		#endif
+	}
+	if ( *current <= 0 ) {
+		*current = *peak;
+	}
+#else
+	*current = 0;
+	*peak = 0;
+#endif
+}
+
+
+
+/*
+   ResetPeakMemory()
+   resets the process peak resident set size to the current one, where supported
+ */
+
+static void ResetPeakMemory( void ){
+#ifdef __linux__
+	FILE            *file;
+
+
+	/* linux 4.0+, silently ignored elsewhere */
+	file = fopen( "/proc/self/clear_refs", "w" );
+	if ( file != NULL ) {
+		fputs( "5", file );
+		fclose( file );
+	}
+#endif
+}
+
+
+
+/*
+   TimingBegin()
+   opens a named timing scope. name must stay valid until WriteTimings()
+ */
+
+void TimingBegin( const char *name ){
+	timingScope_t   *scope;
+	int current, peak;
+
+
+	/* opt-in */
+	if ( !timings ) {
+		return;
+	}
+
+	/* first scope sets the time base */
+	if ( timingBase == 0.0 ) {
+		timingBase = I_PreciseTime();
+	}
+
+	/* push */
+	if ( timingDepth >= MAX_TIMING_DEPTH ) {
+		Error( "MAX_TIMING_DEPTH (%d) exceeded", MAX_TIMING_DEPTH );
+	}
+
+	/* the enclosing scope keeps the peak it has seen so far, since it's about to be reset */
+	ReadMemory( &current, &peak );
+	if ( timingDepth > 0 && peak > timingStack[ timingDepth - 1 ].peakMemory ) {
+		timingStack[ timingDepth - 1 ].peakMemory = peak;
+	}
+	ResetPeakMemory();
+
+	scope = &timingStack[ timingDepth++ ];
+	scope->name = name;
+	scope->busyTime = threadBusyTime;
+	scope->wallTime = threadWallTime;
+	memcpy( scope->threadBusy, threadBusyTimes, sizeof( scope->threadBusy ) );
+	scope->traces = numTraces;
+	scope->startMemory = current;
+	scope->peakMemory = current;
+	scope->start = I_PreciseTime();
+}
+
+
+
+/*
+   TimingEnd()
+   closes the innermost timing scope and records it
+ */
+
+void TimingEnd( void ){
+	timingScope_t   *scope;
+	timingEvent_t   *event;
+	double end, wall;
+	int i, current, peak;
+
+
+	/* opt-in */
+	if ( !timings || timingDepth <= 0 ) {
+		return;
+	}
+
+	/* pop */
+	end = I_PreciseTime();
+	scope = &timingStack[ --timingDepth ];
+
+	/* peak over the scope, including any nested scopes that reset it */
+	ReadMemory( &current, &peak );
+	if ( peak < scope->peakMemory ) {
+		peak = scope->peakMemory;
+	}
+	if ( timingDepth > 0 && peak > timingStack[ timingDepth - 1 ].peakMemory ) {
+		timingStack[ timingDepth - 1 ].peakMemory = peak;
+	}
+
+	/* store event */
+	if ( numTimingEvents >= MAX_TIMING_EVENTS ) {
+		return;
+	}
+	event = &timingEvents[ numTimingEvents++ ];
+	event->name = scope->name;
+	event->depth = timingDepth;
+	event->start = scope->start - timingBase;
+	event->duration = end - scope->start;
+	wall = threadWallTime - scope->wallTime;
+	event->busyFraction = wall > 0.0 ? ( threadBusyTime - scope->busyTime ) / wall : -1.0;
+	event->traces = numTraces - scope->traces;
+	event->peakMemory = peak;
+	event->peakDelta = peak - scope->startMemory;
+
+	/* per thread busy time, against the wall time the threaded sections took */
+	event->numThreads = numthreads < MAX_THREADS ? numthreads : MAX_THREADS;
+	if ( event->numThreads < 1 ) {
+		event->numThreads = 1;
+	}
+	event->threadWall = wall / event->numThreads;
+	event->threadBusy = safe_malloc( event->numThreads * sizeof( *event->threadBusy ) );
+	for ( i = 0; i < event->numThreads; i++ )
+		event->threadBusy[ i ] = threadBusyTimes[ i ] - scope->threadBusy[ i ];
+}
+
+
+
+/*
+   WriteTimings()
+   writes all recorded timing scopes to the -timings file as a chrome trace
+ */
+
+void WriteTimings( void ){
+	int i, j;
+	FILE            *file;
+	timingEvent_t   *event;
+
+
+	/* opt-in */
+	if ( !timings || numTimingEvents <= 0 ) {
+		return;
+	}
+
+	/* close anything left open (eg: early return from a stage) */
+	while ( timingDepth > 0 )
+		TimingEnd();
+
+	/* open file */
+	file = fopen( timingsFile, "w" );
+	if ( file == NULL ) {
+		Sys_Printf( "WARNING: Unable to write timings to %s\n", timingsFile );
+		return;
+	}
+
+	/* write events */
+	fprintf( file, "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n" );
+	for ( i = 0; i < numTimingEvents; i++ )
+	{
+		event = &timingEvents[ i ];
+		fprintf( file, "{ \"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": %.0f, \"dur\": %.0f, "
+				 "\"args\": { \"depth\": %d, \"seconds\": %.6f, \"busyFraction\": %.3f, \"traces\": %d, \"tracesPerSecond\": %.0f, "
+				 "\"peakMemoryKB\": %d, \"peakMemoryDeltaKB\": %d, \"threadBusySeconds\": [",
+				 event->name, event->start * 1000000.0, event->duration * 1000000.0,
+				 event->depth, event->duration, event->busyFraction, event->traces,
+				 event->duration > 0.0 ? event->traces / event->duration : 0.0,
+				 event->peakMemory, event->peakDelta );
+		for ( j = 0; j < event->numThreads; j++ )
+			fprintf( file, "%s%.6f", ( j ? ", " : " " ), event->threadBusy[ j ] );
+		fprintf( file, " ], \"threadBusyFraction\": [" );
+		for ( j = 0; j < event->numThreads; j++ )
+			fprintf( file, "%s%.3f", ( j ? ", " : " " ), event->threadWall > 0.0 ? event->threadBusy[ j ] / event->threadWall : -1.0 );
+		fprintf( file, " ] } }%s\n", ( i + 1 < numTimingEvents ? "," : "" ) );
+	}
+	fprintf( file, "]\n}\n" );
+
+	/* close */
+	fclose( file );
+	Sys_Printf( "Wrote timings to %s\n", timingsFile );
+}
@@ -1069,6 +1069,7 @@ int VisMain( int argc, char **argv ){
 
 	/* note it */
 	Sys_Printf( "--- Vis ---\n" );
+	TimingBegin( "Vis" );
 
 	/* process arguments */
 	for ( i = 1 ; i < ( argc - 1 ) ; i++ )
@@ -1127,18 +1128,23 @@ int VisMain( int argc, char **argv ){
 	StripExtension( source );
 	strcat( source, ".bsp" );
 	Sys_Printf( "Loading %s\n", source );
+	TimingBegin( "LoadBSPFile" );
 	LoadBSPFile( source );
+	TimingEnd();
 
 	/* load the portal file */
 	sprintf( portalfile, "%s%s", inbase, ExpandArg( argv[ i ] ) );
 	StripExtension( portalfile );
 	strcat( portalfile, ".prt" );
 	Sys_Printf( "Loading %s\n", portalfile );
+	TimingBegin( "LoadPortals" );
 	LoadPortals( portalfile );
+	TimingEnd();
 
 	/* ydnar: exit if no portals, hence no vis */
 	if ( numportals == 0 ) {
 		Sys_Printf( "No portals means no vis, exiting.\n" );
+		TimingEnd();
 		return 0;
 	}
 
@@ -1155,7 +1161,9 @@ int VisMain( int argc, char **argv ){
 
 	Sys_Printf( "visdatasize:%i\n", numBSPVisBytes );
 
+	TimingBegin( "CalcVis" );
 	CalcVis();
+	TimingEnd();
 
 	/* delete the prt file */
 	if ( !saveprt ) {
@@ -1164,7 +1172,10 @@ int VisMain( int argc, char **argv ){
 
 	/* write the bsp file */
 	Sys_Printf( "Writing %s\n", source );
+	TimingBegin( "WriteBSPFile" );
 	WriteBSPFile( source );
+	TimingEnd();
 
+	TimingEnd();
 	return 0;
 }